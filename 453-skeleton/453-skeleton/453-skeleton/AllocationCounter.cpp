@@ -0,0 +1,229 @@
+#include "AllocationCounter.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+
+#ifdef COUNT_ALLOCATIONS
+
+namespace {
+	// Constant initialized, so reaching them from operator new never allocates
+	thread_local AllocationCounts threadCounts;
+	std::atomic<std::uint64_t> processAllocationCount{ 0 };
+	std::atomic<std::uint64_t> processFreeCount{ 0 };
+	std::atomic<std::uint64_t> processBytes{ 0 };
+
+	void countAllocation(std::size_t size) {
+		threadCounts.allocations++;
+		threadCounts.bytes += size;
+		processAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		processBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	void countFree() {
+		threadCounts.frees++;
+		processFreeCount.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void* allocate(std::size_t size) {
+		countAllocation(size);
+		return std::malloc(size == 0 ? 1 : size);
+	}
+
+	void* allocateAligned(std::size_t size, std::size_t alignment) {
+		countAllocation(size);
+		if (size == 0) size = 1;
+#if defined(_WIN32)
+		return _aligned_malloc(size, alignment);
+#else
+		// aligned_alloc wants a multiple of the alignment
+		return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+	}
+
+	void release(void* p) {
+		if (p == nullptr) return;
+		countFree();
+		std::free(p);
+	}
+
+	void releaseAligned(void* p) {
+		if (p == nullptr) return;
+		countFree();
+#if defined(_WIN32)
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+
+	void* allocateOrThrow(std::size_t size) {
+		void* p = allocate(size);
+		if (p == nullptr) throw std::bad_alloc();
+		return p;
+	}
+
+	void* allocateAlignedOrThrow(std::size_t size, std::size_t alignment) {
+		void* p = allocateAligned(size, alignment);
+		if (p == nullptr) throw std::bad_alloc();
+		return p;
+	}
+}
+
+
+void* operator new(std::size_t size) { return allocateOrThrow(size); }
+void* operator new[](std::size_t size) { return allocateOrThrow(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, std::size_t(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAlignedOrThrow(size, std::size_t(alignment)); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, std::size_t(alignment)); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocateAligned(size, std::size_t(alignment)); }
+
+void operator delete(void* p) noexcept { release(p); }
+void operator delete[](void* p) noexcept { release(p); }
+void operator delete(void* p, std::size_t) noexcept { release(p); }
+void operator delete[](void* p, std::size_t) noexcept { release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p); }
+void operator delete(void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { releaseAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { releaseAligned(p); }
+
+#endif
+
+
+namespace {
+	struct ScopeTotals {
+		const char* name;
+		std::uint64_t scopes;
+		std::uint64_t allocations;
+		std::uint64_t bytes;
+		std::uint64_t worst;      // most allocations in a single scope
+		std::uint64_t violations;
+	};
+
+	// A fixed table, so recording a scope doesn't allocate inside whatever
+	// scope encloses it. Names past the last slot are only counted as dropped.
+	std::size_t const MAX_NAMES = 64;
+	ScopeTotals totals[MAX_NAMES];
+	std::size_t names = 0;
+	std::uint64_t dropped = 0;
+	std::uint64_t violations = 0;
+	std::mutex totalsMutex;
+
+	AllocationCounts difference(const AllocationCounts& now, const AllocationCounts& start) {
+		AllocationCounts counts;
+		counts.allocations = now.allocations - start.allocations;
+		counts.frees = now.frees - start.frees;
+		counts.bytes = now.bytes - start.bytes;
+		return counts;
+	}
+}
+
+
+bool allocationCountingEnabled() {
+#ifdef COUNT_ALLOCATIONS
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+AllocationCounts threadAllocations() {
+#ifdef COUNT_ALLOCATIONS
+	return threadCounts;
+#else
+	return AllocationCounts();
+#endif
+}
+
+
+AllocationCounts processAllocations() {
+	AllocationCounts counts;
+#ifdef COUNT_ALLOCATIONS
+	counts.allocations = processAllocationCount.load(std::memory_order_relaxed);
+	counts.frees = processFreeCount.load(std::memory_order_relaxed);
+	counts.bytes = processBytes.load(std::memory_order_relaxed);
+#endif
+	return counts;
+}
+
+
+std::uint64_t allocationViolations() {
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	return violations;
+}
+
+
+void reportAllocations() {
+	if (!allocationCountingEnabled()) return;
+
+	std::lock_guard<std::mutex> lock(totalsMutex);
+	for (std::size_t i = 0; i < names; i++) {
+		const ScopeTotals& t = totals[i];
+		Log::info("ALLOCATIONS {}: {} allocations ({} bytes) over {} scopes, {:.1f} per scope, worst {}{}",
+			t.name, t.allocations, t.bytes, t.scopes, double(t.allocations) / double(t.scopes), t.worst,
+			t.violations > 0 ? fmt::format(", {} expected none", t.violations) : "");
+	}
+	if (dropped > 0) Log::warn("ALLOCATIONS {} scopes over the {} name limit were not recorded", dropped, MAX_NAMES);
+
+	AllocationCounts process = processAllocations();
+	Log::info("ALLOCATIONS process: {} allocations ({} bytes), {} frees", process.allocations, process.bytes, process.frees);
+}
+
+
+AllocationScope::AllocationScope(const char* name, Expect expect)
+	: name(name)
+	, expect(expect)
+	, start(threadAllocations())
+{}
+
+
+AllocationScope::~AllocationScope() {
+	if (!allocationCountingEnabled()) return;
+
+	AllocationCounts counts = this->counts();
+	bool violated = (expect == Expect::None && counts.allocations > 0);
+
+	{
+		std::lock_guard<std::mutex> lock(totalsMutex);
+
+		std::size_t i = 0;
+		while (i < names && std::strcmp(totals[i].name, name) != 0) i++;
+		if (i == names) {
+			if (names == MAX_NAMES) {
+				dropped++;
+				return;
+			}
+			totals[names++] = { name, 0, 0, 0, 0, 0 };
+		}
+
+		ScopeTotals& t = totals[i];
+		t.scopes++;
+		t.allocations += counts.allocations;
+		t.bytes += counts.bytes;
+		t.worst = std::max(t.worst, counts.allocations);
+		if (violated) {
+			t.violations++;
+			violations++;
+		}
+	}
+
+	if (violated) Log::error("ALLOCATIONS {} expected none but made {} ({} bytes)", name, counts.allocations, counts.bytes);
+}
+
+
+AllocationCounts AllocationScope::counts() const {
+	return difference(threadAllocations(), start);
+}
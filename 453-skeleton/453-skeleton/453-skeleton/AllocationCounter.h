@@ -0,0 +1,71 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Heap allocation accounting.
+//
+// Configuring with -DCOUNT_ALLOCATIONS=ON replaces the global operator new and
+// delete with versions that count every call. An AllocationScope attributes
+// the allocations its own thread makes during its lifetime to a name, and
+// reportAllocations() logs the totals of every name seen so far. Without the
+// option nothing is replaced, the scopes are empty and every count is 0.
+//
+// Example:
+//		{
+//			AllocationScope scope("generate");
+//			triangles.setLevel(n);
+//		}
+//		{
+//			// Logs an error and counts a violation if anything in here allocates
+//			AllocationScope frame("frame", AllocationScope::Expect::None);
+//			...
+//		}
+//		assert(allocationViolations() == 0);
+//		reportAllocations();
+//------------------------------------------------------------------------------
+
+#include <cstdint>
+
+
+struct AllocationCounts {
+	std::uint64_t allocations = 0;
+	std::uint64_t frees = 0;
+	std::uint64_t bytes = 0; // requested by the allocations, frees don't know their size
+};
+
+
+// False unless built with COUNT_ALLOCATIONS
+bool allocationCountingEnabled();
+
+// Everything the calling thread has allocated so far
+AllocationCounts threadAllocations();
+
+// Everything every thread has allocated so far
+AllocationCounts processAllocations();
+
+// Scopes that expected no allocations and saw some
+std::uint64_t allocationViolations();
+
+// Logs the totals of every scope name
+void reportAllocations();
+
+
+class AllocationScope {
+
+public:
+	enum class Expect { Any, None };
+
+	// The name has to outlive the program, a string literal is best
+	AllocationScope(const char* name, Expect expect = Expect::Any);
+	~AllocationScope();
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope operator=(const AllocationScope&) = delete;
+
+	// Made by this thread since the scope started
+	AllocationCounts counts() const;
+
+private:
+	const char* name;
+	Expect expect;
+	AllocationCounts start;
+};
@@ -0,0 +1,50 @@
+#include "BatchedGeometry.h"
+
+
+BatchedGeometry::BatchedGeometry(VertexFormat format, BufferLayout layout, UploadMode mode)
+	: gpu(format, layout, mode)
+{}
+
+
+void BatchedGeometry::setParts(const std::vector<CPU_Geometry>& parts) {
+	pack(parts, true);
+	gpu.setGeometry(parts.size() == 1 ? parts[0] : packed);
+}
+
+
+void BatchedGeometry::setPartVerts(const std::vector<CPU_Geometry>& parts) {
+	pack(parts, false);
+	gpu.setVerts(parts.size() == 1 ? parts[0].verts : packed.verts);
+}
+
+
+void BatchedGeometry::draw(GLenum mode) {
+	gpu.bind();
+	glMultiDrawArrays(mode, firsts.data(), counts.data(), GLsizei(counts.size()));
+}
+
+
+void BatchedGeometry::pack(const std::vector<CPU_Geometry>& parts, bool colors) {
+	firsts.resize(parts.size());
+	counts.resize(parts.size());
+	vertices = 0;
+	for (std::size_t i = 0; i < parts.size(); i++) {
+		firsts[i] = GLint(vertices);
+		counts[i] = GLsizei(parts[i].verts.size());
+		vertices += parts[i].verts.size();
+	}
+
+	// A single part can go up as it is, only more have to be copied together
+	packed.verts.clear();
+	packed.cols.clear();
+	if (parts.size() == 1) return;
+
+	for (const CPU_Geometry& part : parts) {
+		packed.verts.insert(packed.verts.end(), part.verts.begin(), part.verts.end());
+		if (!colors) continue;
+
+		// Parts with fewer colours than vertices still get theirs next to their vertices
+		packed.cols.insert(packed.cols.end(), part.cols.begin(), part.cols.end());
+		packed.cols.resize(packed.verts.size());
+	}
+}
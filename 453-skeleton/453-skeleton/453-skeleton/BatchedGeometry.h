@@ -0,0 +1,55 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Many parts of a scene in the buffers of one GPU_Geometry.
+//
+// A part is a separate mesh, like one side of the snowflake, but they all go
+// into the same buffers one after the other, in a single upload per buffer.
+// Each part's range is recorded, and one glMultiDrawArrays draws all of them.
+// Every part is still its own strip or fan, nothing joins one to the next.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+
+class BatchedGeometry {
+
+public:
+	BatchedGeometry(VertexFormat format = VertexFormat::Float, BufferLayout layout = BufferLayout::Split,
+		UploadMode mode = UploadMode::Static);
+
+	// Public interface
+
+	// Packs the parts one after the other and uploads them
+	void setParts(const std::vector<CPU_Geometry>& parts);
+
+	// Only their positions, for colours that come from somewhere else, see
+	// GPU_Geometry::disableCols and GPU_Geometry::setValues
+	void setPartVerts(const std::vector<CPU_Geometry>& parts);
+
+	// Binds the buffers and draws every part with one glMultiDrawArrays
+	void draw(GLenum mode);
+
+	// Where to set anything that applies to all parts
+	GPU_Geometry& geometry() { return gpu; }
+
+	std::size_t partCount() const { return counts.size(); }
+	std::size_t vertexCount() const { return vertices; }
+
+private:
+	GPU_Geometry gpu;
+	CPU_Geometry packed; // reused for every upload
+
+	// first vertex and vertex count of each part, as glMultiDrawArrays takes them
+	std::vector<GLint> firsts;
+	std::vector<GLsizei> counts;
+	std::size_t vertices = 0;
+
+	// Records the ranges and packs positions, and colours too if there are any
+	void pack(const std::vector<CPU_Geometry>& parts, bool colors);
+};
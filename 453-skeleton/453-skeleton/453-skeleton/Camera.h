@@ -0,0 +1,53 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A 2D camera for looking at part of a scene up close.
+//
+// The scenes are generated in clip space, so the camera is just the point
+// that ends up in the middle of the window and how much bigger it gets drawn.
+// The shaders apply it with the view uniform, (center, zoom), so moving the
+// camera never has to touch the geometry.
+//
+// Both are kept in double. The shaders only get floats, which is fine as far
+// as maxZoom goes by default, but deep zooms generate their vertices relative
+// to the camera on the CPU instead (see LodFractals.h) and need the rest.
+//------------------------------------------------------------------------------
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+
+struct Camera2D {
+	glm::dvec2 center = glm::dvec2(0.0);
+	double zoom = 1.0;
+
+	// Float positions run out of precision not far past the default
+	static constexpr double MIN_ZOOM = 0.25;
+	double maxZoom = 100000.0;
+
+	glm::dvec2 toClip(glm::dvec2 p) const { return (p - center) * zoom; }
+	glm::dvec2 fromClip(glm::dvec2 clip) const { return clip / zoom + center; }
+
+	// Zooms in by factor (out when it's below 1), keeping the point at clip where it is
+	void zoomAt(glm::dvec2 clip, double factor) {
+		glm::dvec2 fixed = fromClip(clip);
+		zoom = std::clamp(zoom * factor, MIN_ZOOM, maxZoom);
+		center = fixed - clip / zoom;
+	}
+
+	// Moves whatever is on screen by delta in clip space
+	void pan(glm::dvec2 delta) { center -= delta / zoom; }
+
+	// Back to the whole scene
+	void reset() {
+		center = glm::dvec2(0.0);
+		zoom = 1.0;
+	}
+
+	bool operator == (const Camera2D& other) const {
+		return center == other.center && zoom == other.zoom;
+	}
+	bool operator != (const Camera2D& other) const { return !(*this == other); }
+};
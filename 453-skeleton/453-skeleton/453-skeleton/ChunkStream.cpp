@@ -0,0 +1,74 @@
+#include "ChunkStream.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+ChunkStream::ChunkStream(std::size_t budget, VertexFormat format, BufferLayout layout, ThreadPool* pool)
+	: pool(pool)
+{
+	// A pool of one thread only runs tasks inside wait(), which the render
+	// thread never calls here
+	if (pool != nullptr && pool->size() < 2) this->pool = nullptr;
+
+	// Two slots per thread, so the threads fill the next lap while the render
+	// thread uploads and draws this one
+	std::size_t count = (this->pool != nullptr) ? 2 * std::size_t(this->pool->size()) : 1;
+	slots.resize(count);
+	for (Slot& slot : slots) {
+		slot.gpu = std::make_unique<GPU_Geometry>(format, layout, UploadMode::Streaming);
+	}
+
+	// Per vertex, a chunk holds a position and a colour, and the Koch scratch
+	// polylines an x and a y in each of their two buffers for every segment,
+	// which is two vertices. The GPU copy comes on top of that, in a stream
+	// ring that holds four uploads.
+	std::size_t vertexBytes = 2 * sizeof(glm::vec3) + 2 * sizeof(float) + 4 * slots[0].gpu->vertexBytes();
+	maxVertices = std::max(budget / (count * vertexBytes), std::size_t(1));
+}
+
+
+void ChunkStream::fillAsync(const ChunkedFractal& fractal, std::size_t index, Slot& slot) {
+	slot.filled = false;
+	pool->submit([this, &fractal, index, &slot]() {
+		fractal.fill(index, slot.chunk);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		slot.filled = true;
+		filledSignal.notify_all();
+	});
+}
+
+
+void ChunkStream::draw(const ChunkedFractal& fractal, GLenum mode) {
+	counters = Stats();
+
+	std::size_t chunks = fractal.chunkCount();
+	if (pool != nullptr) {
+		for (std::size_t i = 0; i < std::min(slots.size(), chunks); i++) fillAsync(fractal, i, slots[i]);
+	}
+
+	for (std::size_t index = 0; index < chunks; index++) {
+		Slot& slot = slots[index % slots.size()];
+
+		if (pool != nullptr) {
+			std::unique_lock<std::mutex> lock(mutex);
+			filledSignal.wait(lock, [&slot]() { return slot.filled; });
+		}
+		else {
+			fractal.fill(index, slot.chunk);
+		}
+
+		const CPU_Geometry& geom = slot.chunk.geometry;
+		slot.gpu->setGeometry(geom);
+		slot.gpu->bind();
+		glDrawArrays(mode, 0, GLsizei(geom.verts.size()));
+		counters.vertices += geom.verts.size();
+		counters.chunks++;
+
+		// The upload copied the chunk, so the slot can take the next one right away
+		std::size_t next = index + slots.size();
+		if (pool != nullptr && next < chunks) fillAsync(fractal, next, slot);
+	}
+}
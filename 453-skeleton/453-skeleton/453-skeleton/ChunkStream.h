@@ -0,0 +1,73 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Draws a ChunkedFractal through a fixed pool of chunks.
+//
+// The pool holds one Chunk and one GPU_Geometry per slot, two slots per thread
+// of the thread pool. Chunk i goes into slot i % slots. The thread pool fills
+// the slots ahead of the render thread, which only waits for the chunk it is
+// about to upload and draw and then hands that slot back to be filled with the
+// chunk one lap of the slots later. The slots' geometry always streams, so
+// uploading into a slot whose last chunk may still be drawn never waits.
+//
+// Nothing of the level is kept once it is drawn, so drawing it again generates
+// it again, but memory stays within the budget the pool was sized for no
+// matter how deep the level is. How long that takes does depend on the level,
+// so callers bound the level by how many vertices it has.
+//------------------------------------------------------------------------------
+
+#include "ChunkedFractals.h"
+#include "Geometry.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class ThreadPool;
+
+
+class ChunkStream {
+
+public:
+	// Sizes the chunks so the whole pool, on the CPU and on the GPU, fits in budget bytes
+	ChunkStream(std::size_t budget, VertexFormat format, BufferLayout layout, ThreadPool* pool = nullptr);
+
+	// Public interface
+
+	// Generates, uploads and draws every chunk of the fractal's current level,
+	// which has to have been set up with chunkVertices() or less. Every chunk
+	// is done with by the time it returns.
+	void draw(const ChunkedFractal& fractal, GLenum mode);
+
+	std::size_t chunkVertices() const { return maxVertices; }
+	std::size_t slotCount() const { return slots.size(); }
+
+	struct Stats {
+		std::size_t chunks = 0;   // during the last draw
+		std::size_t vertices = 0; // during the last draw
+	};
+	const Stats& stats() const { return counters; }
+
+private:
+	struct Slot {
+		Chunk chunk;
+		std::unique_ptr<GPU_Geometry> gpu;
+		bool filled = false; // guarded by mutex while the thread pool has the slot
+	};
+
+	std::vector<Slot> slots;
+	std::size_t maxVertices;
+	ThreadPool* pool; // null when it couldn't run tasks without being waited on
+
+	std::mutex mutex;
+	std::condition_variable filledSignal;
+
+	// Hands slot to the thread pool to fill with chunk index of fractal
+	void fillAsync(const ChunkedFractal& fractal, std::size_t index, Slot& slot);
+
+	Stats counters;
+};
@@ -0,0 +1,113 @@
+#include "ChunkedFractals.h"
+
+#include "Fractals.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+ChunkedSerpinsky::ChunkedSerpinsky(glm::vec2 a, glm::vec2 b, glm::vec2 c)
+	: a(a), b(b), c(c)
+{}
+
+
+void ChunkedSerpinsky::setLevel(int iterations, std::size_t maxVertices) {
+	this->iterations = std::clamp(iterations, 0, MAX_CHUNKED_ITERATIONS);
+
+	// The deepest subtrees that still fit, a single triangle at the least
+	int depth = 0;
+	while (depth < this->iterations && 3 * serpinskyTriangleCount(depth + 1) <= maxVertices) depth++;
+
+	split = this->iterations - depth;
+	chunks = serpinskyTriangleCount(split);
+	vertices = 3 * serpinskyTriangleCount(depth);
+}
+
+
+void ChunkedSerpinsky::fill(std::size_t index, Chunk& chunk) const {
+	CPU_Geometry& geom = chunk.geometry;
+	geom.verts.resize(vertices);
+	fillSerpinskySubtree(geom.verts.data(), a, b, c, iterations, split, index);
+
+	colorSerpinsky(geom, iterations, index * vertices);
+}
+
+
+//------------------------------------------------------------------------------
+
+
+ChunkedSnowflake::ChunkedSnowflake(glm::vec2 a, glm::vec2 b, glm::vec2 c)
+	: corners{ a, b, c }
+{}
+
+
+void ChunkedSnowflake::setLevel(int iterations, std::size_t maxVertices) {
+	this->iterations = std::clamp(iterations, 0, MAX_CHUNKED_ITERATIONS);
+
+	// A chunk has to be at least one level deep, snowflakeSegments only colours
+	// segments by which child they are when it sees them together with their siblings
+	int depth = std::min(this->iterations, 1);
+	while (depth < this->iterations && 2 * snowflakeSegmentCount(depth + 1) <= maxVertices) depth++;
+
+	split = this->iterations - depth;
+	chunks = 3 * snowflakeSegmentCount(split);
+	vertices = 2 * snowflakeSegmentCount(depth);
+}
+
+
+void ChunkedSnowflake::fill(std::size_t index, Chunk& chunk) const {
+	std::size_t perSide = chunks / 3;
+	std::size_t side = index / perSide;
+	std::size_t segment = index % perSide;
+
+	// Refine only the segment on the way down. The base 4 digits of its index
+	// (most significant first) say which child to take at each level.
+	float x[2] = { corners[side].x, corners[(side + 1) % 3].x };
+	float y[2] = { corners[side].y, corners[(side + 1) % 3].y };
+	std::size_t digit = perSide / 4;
+	for (int level = 0; level < split; level++, digit /= 4) {
+		float childX[5], childY[5];
+		kochSubdivide(x, y, 1, childX, childY, KochPath::Scalar);
+
+		std::size_t child = (segment / digit) % 4;
+		x[0] = childX[child]; x[1] = childX[child + 1];
+		y[0] = childY[child]; y[1] = childY[child + 1];
+	}
+
+	generateSnowflakeBreadthFirst(chunk.geometry, glm::vec2(x[0], y[0]), glm::vec2(x[1], y[1]), iterations - split, chunk.scratch);
+}
+
+
+//------------------------------------------------------------------------------
+
+
+ChunkedSquareDiamond::ChunkedSquareDiamond(std::vector<std::vector<float>> initialPoints)
+	: initialPoints(initialPoints)
+{}
+
+
+void ChunkedSquareDiamond::setLevel(int iterations, std::size_t maxVertices) {
+	this->iterations = std::clamp(iterations, 0, MAX_CHUNKED_ITERATIONS);
+	total = squareDiamondVertexCount(this->iterations);
+
+	// Every chunk after the first repeats the last vertex of the one before
+	vertices = std::min(std::max(maxVertices, std::size_t(2)), total);
+	chunks = (total - 2) / (vertices - 1) + 1;
+}
+
+
+void ChunkedSquareDiamond::fill(std::size_t index, Chunk& chunk) const {
+	std::size_t begin = index * (vertices - 1);
+	std::size_t end = std::min(begin + vertices, total);
+
+	CPU_Geometry& geom = chunk.geometry;
+	geom.verts.resize(end - begin);
+	geom.cols.resize(end - begin);
+	for (std::size_t v = begin; v < end; v++) {
+		// Level i is the initial points at half the size of level i - 1, see SquareDiamondLevels::refine
+		std::size_t level = v / initialPoints.size();
+		std::size_t point = v % initialPoints.size();
+		geom.verts[v - begin] = squareDiamondPoint(initialPoints[point], std::ldexp(1.f, -int(level)));
+		geom.cols[v - begin] = (point < 5) ? BLUE : RED;
+	}
+}
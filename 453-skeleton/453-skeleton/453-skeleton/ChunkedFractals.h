@@ -0,0 +1,109 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Fractals split into fixed size chunks.
+//
+// A deep level doesn't fit in memory as a whole, but every scene can be cut
+// into pieces that can each be generated on their own: a subtree of the
+// Serpinsky triangle, a subtree of one Koch segment, a range of the square
+// diamond's vertices. These generate one piece at a time into a Chunk, which
+// can be uploaded, drawn and then filled with the next piece, so memory only
+// depends on the chunk size and not on the level.
+//
+// Chunks are drawn one after the other with the same primitive as the whole
+// level. Line strip chunks start on the last vertex of the chunk before them,
+// so the pieces join up.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "Koch.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+// Deepest level a chunked fractal can be split at. Chunk indices of every scene
+// still fit in a size_t there. Drawing a level takes time proportional to its
+// vertices, so callers should stop well before this (see --chunked-vertices).
+int const MAX_CHUNKED_ITERATIONS = 20;
+
+
+// One slot of a chunk pool. scratch is only used by generators that need room to work in.
+struct Chunk {
+	CPU_Geometry geometry;
+	KochBuffers scratch;
+};
+
+
+class ChunkedFractal {
+
+public:
+	virtual ~ChunkedFractal() = default;
+
+	// Public interface
+
+	// Splits the given level into chunks of at most maxVertices vertices. Some
+	// levels can't be split that finely, their chunks are as small as they go.
+	virtual void setLevel(int iterations, std::size_t maxVertices) = 0;
+
+	// Overwrites chunk with chunk index of the level. Chunks don't depend on each
+	// other, so several can be filled at once from different threads.
+	virtual void fill(std::size_t index, Chunk& chunk) const = 0;
+
+	std::size_t chunkCount() const { return chunks; }
+	std::size_t chunkVertices() const { return vertices; } // the most any chunk has
+
+protected:
+	int iterations = 0;
+	std::size_t chunks = 1;
+	std::size_t vertices = 0;
+};
+
+
+// Each chunk is one of the subtrees some levels below the whole triangle
+class ChunkedSerpinsky : public ChunkedFractal {
+
+public:
+	ChunkedSerpinsky(glm::vec2 a, glm::vec2 b, glm::vec2 c);
+
+	void setLevel(int iterations, std::size_t maxVertices) override;
+	void fill(std::size_t index, Chunk& chunk) const override;
+
+private:
+	glm::vec2 a, b, c;
+	int split = 0; // levels above the chunks
+};
+
+
+// The three sides of the snowflake, each chunk the Koch curve of one segment
+// some levels below a side. The path down to that segment is refined on its
+// own, without the rest of the level.
+class ChunkedSnowflake : public ChunkedFractal {
+
+public:
+	ChunkedSnowflake(glm::vec2 a, glm::vec2 b, glm::vec2 c);
+
+	void setLevel(int iterations, std::size_t maxVertices) override;
+	void fill(std::size_t index, Chunk& chunk) const override;
+
+private:
+	glm::vec2 corners[3];
+	int split = 0; // levels above the chunks
+};
+
+
+// Ranges of the vertices generateSquareDiamond emits, worked out from their index
+class ChunkedSquareDiamond : public ChunkedFractal {
+
+public:
+	ChunkedSquareDiamond(std::vector<std::vector<float>> initialPoints);
+
+	void setLevel(int iterations, std::size_t maxVertices) override;
+	void fill(std::size_t index, Chunk& chunk) const override;
+
+private:
+	std::vector<std::vector<float>> initialPoints;
+	std::size_t total = 0; // vertices in the whole level
+};
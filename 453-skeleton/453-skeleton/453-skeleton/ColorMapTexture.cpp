@@ -0,0 +1,78 @@
+#include "ColorMapTexture.h"
+
+#include <vivid/data.h>
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+
+namespace {
+	struct Map {
+		const char* name;
+		const std::vector<vivid::srgb_t>* stops;
+	};
+
+	// Every preset of vivid::ColorMap
+	Map const MAPS[] = {
+		{ "viridis", &vivid::data::viridis },
+		{ "inferno", &vivid::data::inferno },
+		{ "magma", &vivid::data::magma },
+		{ "plasma", &vivid::data::plasma },
+		{ "turbo", &vivid::data::turbo },
+		{ "cool-warm", &vivid::data::cool_warm },
+		{ "blue-yellow", &vivid::data::blue_yellow },
+		{ "rainbow", &vivid::data::rainbow },
+		{ "hsl", &vivid::data::hsl },
+		{ "hsl-pastel", &vivid::data::hsl_pastel },
+		{ "vivid", &vivid::data::vivid },
+	};
+
+	// The colour at t like ColorMap::at with linear interpolation
+	glm::vec3 at(const std::vector<vivid::srgb_t>& stops, float t) {
+		float s = glm::clamp(t, 0.f, 1.f) * float(stops.size() - 1);
+		std::size_t k = std::min(std::size_t(s), stops.size() - 2);
+		return glm::mix(glm::vec3(stops[k]), glm::vec3(stops[k + 1]), s - float(k));
+	}
+}
+
+
+ColorMapTexture::ColorMapTexture() {
+	std::vector<glm::vec3> texels;
+	texels.reserve(WIDTH * std::size(MAPS));
+	for (const Map& map : MAPS) {
+		for (int i = 0; i < WIDTH; i++) texels.push_back(at(*map.stops, float(i) / float(WIDTH - 1)));
+	}
+
+	glBindTexture(GL_TEXTURE_1D_ARRAY, texture);
+	glTexImage2D(GL_TEXTURE_1D_ARRAY, 0, GL_SRGB8, WIDTH, GLsizei(std::size(MAPS)), 0, GL_RGB, GL_FLOAT, texels.data());
+	glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_1D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+}
+
+
+void ColorMapTexture::bind(GLuint unit) const {
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_1D_ARRAY, texture);
+}
+
+
+int ColorMapTexture::find(const std::string& name) {
+	for (int layer = 0; layer < count(); layer++) {
+		if (name == MAPS[layer].name) return layer;
+	}
+	return -1;
+}
+
+
+int ColorMapTexture::count() {
+	return int(std::size(MAPS));
+}
+
+
+const char* ColorMapTexture::name(int layer) {
+	return MAPS[layer].name;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// vivid's colour maps baked into a 1D texture array, one layer per map.
+//
+// With one, a vertex only needs a single value in [0, 1] instead of a colour
+// (see GPU_Geometry::setValues), which shaders/colormap.frag looks up. Switching
+// to another map is a uniform, nothing is uploaded again.
+//
+// vivid::ColorMap itself is in vivid's compiled library, which this build
+// doesn't link, so the maps are made from the same stop tables in vivid/data.
+// The texture unit interpolates linearly between them like
+// ColorMap::Interpolation::Linear. The stops are sRGB and so is the texture,
+// so colours come out as they should with GL_FRAMEBUFFER_SRGB.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <string>
+
+
+class ColorMapTexture {
+
+public:
+	// Texels per map, as many stops as the most detailed of vivid's maps have
+	static int const WIDTH = 256;
+
+	ColorMapTexture();
+
+	// Public interface
+	void bind(GLuint unit = 0) const;
+
+	// The layer of a map by its name like "viridis", -1 if there is none
+	static int find(const std::string& name);
+	static int count();
+	static const char* name(int layer);
+
+private:
+	TextureHandle texture;
+};
@@ -0,0 +1,68 @@
+#include "FeedbackProgram.h"
+
+#include <stdexcept>
+
+#include "Log.h"
+
+
+FeedbackProgram::FeedbackProgram(const std::string& vertexPath, const std::string& geometryPath, const std::vector<std::string>& varyings)
+	: programID()
+	, vertex(vertexPath, GL_VERTEX_SHADER)
+	, geometry(geometryPath, GL_GEOMETRY_SHADER)
+	, varyings(varyings)
+{
+	attach(*this, vertex);
+	attach(*this, geometry);
+
+	// Has to be set before linking
+	std::vector<const GLchar*> names;
+	for (const std::string& varying : varyings) names.push_back(varying.c_str());
+	glTransformFeedbackVaryings(programID, GLsizei(names.size()), names.data(), GL_INTERLEAVED_ATTRIBS);
+
+	glLinkProgram(programID);
+
+	if (!checkAndLogLinkSuccess()) {
+		glDeleteProgram(programID);
+		throw std::runtime_error("Feedback shaders did not link.");
+	}
+}
+
+bool FeedbackProgram::recompile() {
+
+	try {
+		// Try to create a new program
+		FeedbackProgram newProgram(vertex.getPath(), geometry.getPath(), varyings);
+		*this = std::move(newProgram);
+		return true;
+	}
+	catch (std::runtime_error &e) {
+		Log::warn("FEEDBACK_PROGRAM falling back to previous version of shaders");
+		return false;
+	}
+}
+
+
+void attach(FeedbackProgram& fp, Shader& s) {
+	glAttachShader(fp.programID, s.shaderID);
+}
+
+
+bool FeedbackProgram::checkAndLogLinkSuccess() const {
+
+	GLint success;
+
+	glGetProgramiv(programID, GL_LINK_STATUS, &success);
+	if (!success) {
+		GLint logLength;
+		glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+		std::vector<char> log(logLength);
+		glGetProgramInfoLog(programID, logLength, NULL, log.data());
+
+		Log::error("FEEDBACK_PROGRAM linking {} + {}:\n{}", vertex.getPath(), geometry.getPath(), log.data());
+		return false;
+	}
+	else {
+		Log::info("FEEDBACK_PROGRAM successfully compiled and linked {} + {}", vertex.getPath(), geometry.getPath());
+		return true;
+	}
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Shader.h"
+
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+
+// A vertex + geometry shader program whose output is captured with transform
+// feedback instead of being rasterized. The captured varyings are written
+// interleaved, in the order given, into the buffer bound to
+// GL_TRANSFORM_FEEDBACK_BUFFER index 0.
+class FeedbackProgram {
+
+public:
+	FeedbackProgram(const std::string& vertexPath, const std::string& geometryPath, const std::vector<std::string>& varyings);
+
+	// Rule of zero, same as ShaderProgram
+
+	// Public interface
+	bool recompile();
+	void use() const { glUseProgram(programID); }
+	GLint uniformLocation(const char* name) const { return glGetUniformLocation(programID, name); }
+
+	void friend attach(FeedbackProgram& fp, Shader& s);
+
+private:
+	ShaderProgramHandle programID;
+
+	Shader vertex;
+	Shader geometry;
+	std::vector<std::string> varyings;
+
+	bool checkAndLogLinkSuccess() const;
+};
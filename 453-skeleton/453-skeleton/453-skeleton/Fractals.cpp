@@ -0,0 +1,425 @@
+#define _USE_MATH_DEFINES
+#include "Fractals.h"
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+#include <stdlib.h>
+
+
+// Random float between 0 and 1 found at https://stackoverflow.com/questions/9878965/rand-between-0-and-1
+float randomFloat() {
+	float r = ((float) rand() / (RAND_MAX));
+	return r;
+}
+
+// Helper function for entering points as data
+glm::vec3 point(std::vector<float> point) {
+	return glm::vec3(point[0], point[1], 0.f);
+}
+
+// Point rotation referenced from https://www.geeksforgeeks.org/basic-transformations-opengl/#:~:text=To%20rotate%20around%20a%20different,x%2C%20y%2C%20z).
+std::vector<float> rotatePoint(std::vector<float> point, std::vector<float> pivot, float angle) {
+	int x = 0;
+	int y = 1;
+
+	float angleInRadians = angle * (float)(M_PI / 180.f);
+	float rotatedX = pivot[x] + (point[x] - pivot[x]) * cos(angleInRadians) - (point[y] - pivot[y]) * sin(angleInRadians);
+	float rotatedY = pivot[x] + (point[x] - pivot[x]) * sin(angleInRadians) + (point[y] - pivot[y])* cos(angleInRadians);
+
+	std::vector<float> newPoint{ rotatedX, rotatedY };
+	return newPoint;
+}
+
+// Gets a point in between p and q given an alpha value
+std::vector<float> pointOnLine(float alpha, std::vector<float> p, std::vector<float> q) {
+	int x = 0;
+	int y = 1;
+
+	float newX = (float)(1 - alpha) * p[x] + alpha * q[x];
+	float newY = (float)(1 - alpha) * p[y] + alpha * q[y];
+
+	std::vector<float> newPoint{ newX, newY };
+	return newPoint;
+}
+
+// Calculates vector made by two points
+std::vector<float> getVectorFromPoints(std::vector<float> p, std::vector<float> q) {
+	float firstElement = q[0] - p[0];
+	float secondElement = q[1] - p[1];
+	std::vector<float> vector{ firstElement, secondElement };
+	return vector;
+}
+
+// Moves a point along a vector
+std::vector<float> getPointFromVector(std::vector<float> point, glm::vec3 vector) {
+	float newX = point[0] + (float)vector.x;
+	float newY = point[1] + (float)vector.y;
+	std::vector<float> newPoint{ newX, newY };
+	return newPoint;
+}
+
+// Gets points for square diamond
+glm::vec3 squareDiamondPoint(std::vector<float> point, float factor) {
+	return glm::vec3((point[0] * factor), (point[1] * factor), 0.f);
+}
+
+
+// Gets midpoint of two vertices
+std::vector<float> midPoint(std::vector<float> vertex1, std::vector<float> vertex2) {
+	std::vector<float> point;
+	for (int i = 0; i < 2; i++) point.push_back((vertex1[i] * 0.5) + (vertex2[i] * 0.5));
+	return point;
+}
+
+void generateSerpinsky(std::vector<float> a, std::vector<float> b, std::vector<float> c, CPU_Geometry& triangle, int iterations) {
+	if (iterations > 0) {
+		std::vector<float> d = midPoint(a, b);
+		std::vector<float> e = midPoint(a, c);
+		std::vector<float> f = midPoint(b, c);
+		generateSerpinsky(a, d, e, triangle, iterations - 1);
+		generateSerpinsky(d, b, f, triangle, iterations - 1);
+		generateSerpinsky(e, f, c, triangle, iterations - 1);
+	}
+	else {
+		triangle.verts.push_back(glm::vec3(a[0], a[1], 0.f));
+		triangle.verts.push_back(glm::vec3(b[0], b[1], 0.f));
+		triangle.verts.push_back(glm::vec3(c[0], c[1], 0.f));
+	}
+}
+
+void serpinskyAllColored(CPU_Geometry& triangle) {
+	for (int vert = 0; vert < triangle.verts.size(); vert++) triangle.cols.push_back(glm::vec3(randomFloat(), randomFloat(), randomFloat()));
+}
+
+std::uint32_t serpinskyHash(std::uint32_t x) {
+	// lowbias32 by Chris Wellons, https://nullprogram.com/blog/2018/07/31/
+	// Keep in step with shaders/serpinsky_color.glsl
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+glm::vec3 serpinskyColor(int level, std::uint64_t vertex) {
+	// Vertex indices past 32 bits wrap, which only repeats colours
+	std::uint32_t h = serpinskyHash(std::uint32_t(vertex) + serpinskyHash(std::uint32_t(level)));
+	return glm::vec3(
+		float(h & 0x7ffu) / 2047.f,
+		float((h >> 11) & 0x7ffu) / 2047.f,
+		float(h >> 22) / 1023.f
+	);
+}
+
+void colorSerpinsky(CPU_Geometry& triangle, int level, std::uint64_t firstVertex, ThreadPool* pool) {
+	triangle.cols.resize(triangle.verts.size());
+	glm::vec3* cols = triangle.cols.data();
+	std::size_t count = triangle.cols.size();
+
+	auto fill = [=](std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; i++) cols[i] = serpinskyColor(level, firstVertex + i);
+	};
+
+	if (pool == nullptr) {
+		fill(0, count);
+		return;
+	}
+
+	std::size_t chunk = count / (4 * pool->size()) + 1;
+	for (std::size_t begin = 0; begin < count; begin += chunk) {
+		std::size_t end = std::min(begin + chunk, count);
+		pool->submit([=]() { fill(begin, end); });
+	}
+	pool->wait();
+}
+
+void serpinskyBranchValues(std::size_t vertices, std::vector<float>& values) {
+	std::size_t triangles = vertices / 3;
+	values.resize(vertices);
+	for (std::size_t i = 0; i < vertices; i++) {
+		values[i] = (triangles > 1) ? float(i / 3) / float(triangles - 1) : 0.f;
+	}
+}
+
+void squareDiamondDepthValues(std::size_t vertices, std::size_t pointsPerLevel, std::vector<float>& values) {
+	std::size_t levels = (vertices + pointsPerLevel - 1) / pointsPerLevel;
+	values.resize(vertices);
+	for (std::size_t i = 0; i < vertices; i++) {
+		values[i] = (levels > 1) ? float(i / pointsPerLevel) / float(levels - 1) : 0.f;
+	}
+}
+
+void arcLengthValues(const std::vector<glm::vec3>& verts, std::vector<float>& values, float from, float to) {
+	values.resize(verts.size());
+	if (verts.empty()) return;
+
+	// Summed in double, a deep level has millions of tiny segments
+	double length = 0.0;
+	values[0] = 0.f;
+	for (std::size_t i = 1; i < verts.size(); i++) {
+		length += glm::length(glm::dvec3(verts[i] - verts[i - 1]));
+		values[i] = float(length);
+	}
+
+	float scale = (length > 0.0) ? float((to - from) / length) : 0.f;
+	for (float& value : values) value = from + value * scale;
+}
+
+void colorAllVerts(CPU_Geometry& cpuGeom, glm::vec3 color) {
+	for (int vert = 0; vert < cpuGeom.verts.size(); vert++) cpuGeom.cols.push_back(color);
+}
+
+void generateSquareDiamond(CPU_Geometry& squareDiamond, int iterations, std::vector<std::vector<float>> initialPoints) {
+	// An interesting observation I made is that the next 2 shapes are half the size of the first 2
+	float factor = 0.5f;
+
+	for (int i = 0; i < initialPoints.size(); i++) squareDiamond.verts.push_back(point(initialPoints[i]));
+
+	for (int i = 0; i < iterations; i++) {
+		for (int j = 0; j < initialPoints.size(); j++) squareDiamond.verts.push_back(squareDiamondPoint(initialPoints[j], factor));
+		squareDiamond.cols.push_back(BLUE);
+		squareDiamond.cols.push_back(BLUE);
+		squareDiamond.cols.push_back(BLUE);
+		squareDiamond.cols.push_back(BLUE);
+		squareDiamond.cols.push_back(BLUE);
+		squareDiamond.cols.push_back(RED);
+		squareDiamond.cols.push_back(RED);
+		squareDiamond.cols.push_back(RED);
+		squareDiamond.cols.push_back(RED);
+		squareDiamond.cols.push_back(RED);
+		factor *= 0.5f;
+	}
+
+
+}
+
+// Function to generate geometry for koch snowflake
+void generateSnowflake(CPU_Geometry& snowflake, std::vector<float> startingPoint, std::vector<float> endingPoint, glm::vec3 color, int iterations) {
+	float firstPointAlpha = 1.f / 3.f;
+	float lastPointAlpha = 2.f / 3.f;
+	float endPointAlpha = 1.f;
+	if (iterations > 0) {
+		std::vector<float> firstPoint = pointOnLine(firstPointAlpha, startingPoint, endingPoint);
+		std::vector<float> lastPoint = pointOnLine(lastPointAlpha, startingPoint, endingPoint);
+		std::vector<float> middle = rotatePoint(firstPoint, lastPoint, 60.0);
+
+
+		generateSnowflake(snowflake, startingPoint, firstPoint, BLUE,iterations - 1);
+		generateSnowflake(snowflake, firstPoint, middle, GREEN, iterations - 1);
+		generateSnowflake(snowflake, middle, lastPoint, RED, iterations - 1);
+		generateSnowflake(snowflake, lastPoint, endingPoint, YELLOW, iterations - 1);
+	}
+	else {
+		snowflake.verts.push_back(point(startingPoint));
+		snowflake.verts.push_back(point(endingPoint));
+		snowflake.cols.push_back(color);
+		snowflake.cols.push_back(color);
+	}
+}
+
+
+//------------------------------------------------------------------------------
+
+
+std::size_t serpinskyTriangleCount(int iterations) {
+	std::size_t count = 1;
+	for (int i = 0; i < iterations; i++) count *= 3;
+	return count;
+}
+
+
+namespace {
+	// One pending call of the recursion in generateSerpinsky
+	struct SerpinskyFrame {
+		glm::vec2 a, b, c;
+		int iterations;
+	};
+
+	// Same rounding as midPoint: both halves are exact, so only the sum rounds
+	glm::vec2 half(glm::vec2 p, glm::vec2 q) {
+		return p * 0.5f + q * 0.5f;
+	}
+
+	// Replaces abc with one of the three triangles generateSerpinsky recurses into
+	void serpinskyChild(glm::vec2& a, glm::vec2& b, glm::vec2& c, std::size_t child) {
+		glm::vec2 d = half(a, b);
+		glm::vec2 e = half(a, c);
+		glm::vec2 f = half(b, c);
+		if (child == 0) { b = d; c = e; }
+		else if (child == 1) { a = d; c = f; }
+		else { a = e; b = f; }
+	}
+}
+
+
+void fillSerpinsky(glm::vec3* out, glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations) {
+	// Each pop pushes at most 3 frames, one level deeper, so the stack never
+	// holds more than 2 frames per level plus the one being expanded.
+	assert(iterations >= 0 && iterations <= MAX_SERPINSKY_ITERATIONS);
+	SerpinskyFrame stack[2 * MAX_SERPINSKY_ITERATIONS + 1];
+	int top = 0;
+	stack[top++] = { a, b, c, iterations };
+
+	while (top > 0) {
+		SerpinskyFrame frame = stack[--top];
+
+		if (frame.iterations == 0) {
+			*out++ = glm::vec3(frame.a, 0.f);
+			*out++ = glm::vec3(frame.b, 0.f);
+			*out++ = glm::vec3(frame.c, 0.f);
+			continue;
+		}
+
+		glm::vec2 d = half(frame.a, frame.b);
+		glm::vec2 e = half(frame.a, frame.c);
+		glm::vec2 f = half(frame.b, frame.c);
+
+		if (frame.iterations == 1) {
+			// Emit the last level directly instead of pushing three leaves
+			*out++ = glm::vec3(frame.a, 0.f); *out++ = glm::vec3(d, 0.f); *out++ = glm::vec3(e, 0.f);
+			*out++ = glm::vec3(d, 0.f); *out++ = glm::vec3(frame.b, 0.f); *out++ = glm::vec3(f, 0.f);
+			*out++ = glm::vec3(e, 0.f); *out++ = glm::vec3(f, 0.f); *out++ = glm::vec3(frame.c, 0.f);
+			continue;
+		}
+
+		// Pushed in reverse so they are popped in the same order the recursion visits them
+		stack[top++] = { e, f, frame.c, frame.iterations - 1 };
+		stack[top++] = { d, frame.b, f, frame.iterations - 1 };
+		stack[top++] = { frame.a, d, e, frame.iterations - 1 };
+	}
+}
+
+
+void fillSerpinskySubtree(glm::vec3* out, glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations, int split, std::size_t subtree) {
+	// The base 3 digits of the subtree index (most significant first) are the
+	// children taken at each level, which is also why subtrees in index order
+	// land in the same order the serial traversal writes them.
+	std::size_t digit = serpinskyTriangleCount(split) / 3;
+	for (int level = 0; level < split; level++, digit /= 3) {
+		serpinskyChild(a, b, c, (subtree / digit) % 3);
+	}
+	fillSerpinsky(out, a, b, c, iterations - split);
+}
+
+
+void generateSerpinskyIterative(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, int iterations) {
+	iterations = std::clamp(iterations, 0, MAX_SERPINSKY_ITERATIONS);
+	triangle.verts.resize(3 * serpinskyTriangleCount(iterations));
+	fillSerpinsky(triangle.verts.data(), a, b, c, iterations);
+}
+
+
+void generateSerpinskyParallel(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, int iterations,
+	ThreadPool& pool, int splitIterations)
+{
+	iterations = std::clamp(iterations, 0, MAX_SERPINSKY_ITERATIONS);
+	int split = std::min(std::max(splitIterations, 0), iterations);
+	std::size_t subtrees = serpinskyTriangleCount(split);
+	std::size_t subtreeVerts = 3 * serpinskyTriangleCount(iterations - split);
+
+	triangle.verts.resize(3 * serpinskyTriangleCount(iterations));
+	glm::vec3* out = triangle.verts.data();
+
+	for (std::size_t subtree = 0; subtree < subtrees; subtree++) {
+		pool.submit([=]() {
+			fillSerpinskySubtree(out + subtree * subtreeVerts, a, b, c, iterations, split, subtree);
+		});
+	}
+	pool.wait();
+}
+
+
+void generateSerpinskyInstances(glm::vec2 a, glm::vec2 b, glm::vec2 c, int depth, std::vector<glm::vec3>& instances) {
+	instances.resize(serpinskyTriangleCount(depth));
+
+	// Only the first corner of every copy is tracked at first. A copy at scale s with
+	// first corner p has children at p, p + s/2 (b - a) and p + s/2 (c - a), which are
+	// expanded in place back to front like SerpinskyLevels::refine.
+	std::size_t count = 1;
+	instances[0] = glm::vec3(a, 1.f);
+
+	float scale = 1.f;
+	for (int level = 0; level < depth; level++) {
+		scale *= 0.5f;
+		glm::vec3 toB(scale * (b - a), 0.f);
+		glm::vec3 toC(scale * (c - a), 0.f);
+
+		for (std::size_t i = count; i-- > 0;) {
+			glm::vec3 p(glm::vec2(instances[i]), scale);
+			instances[3 * i + 0] = p;
+			instances[3 * i + 1] = p + toB;
+			instances[3 * i + 2] = p + toC;
+		}
+		count *= 3;
+	}
+
+	// Corners to offsets, so the base mesh's own first corner a lands on them
+	glm::vec2 shift = scale * a;
+	for (glm::vec3& instance : instances) {
+		instance.x -= shift.x;
+		instance.y -= shift.y;
+	}
+}
+
+
+std::size_t snowflakeSegmentCount(int iterations) {
+	std::size_t count = 1;
+	for (int i = 0; i < iterations; i++) count *= 4;
+	return count;
+}
+
+
+std::size_t squareDiamondVertexCount(int iterations) {
+	return 10 * (std::size_t(iterations) + 1);
+}
+
+
+std::size_t serpinskyVertexCount(int iterations) {
+	return (3 * serpinskyTriangleCount(iterations) + 3) / 2;
+}
+
+
+void generateSerpinskyIndexed(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, std::vector<std::uint32_t>& indices,
+	int iterations)
+{
+	iterations = std::clamp(iterations, 0, MAX_INDEXED_SERPINSKY_ITERATIONS);
+	triangle.verts.resize(serpinskyVertexCount(iterations));
+	indices.resize(3 * serpinskyTriangleCount(iterations));
+	glm::vec3* verts = triangle.verts.data();
+	std::uint32_t* index = indices.data();
+
+	verts[0] = glm::vec3(a, 0.f);
+	verts[1] = glm::vec3(b, 0.f);
+	verts[2] = glm::vec3(c, 0.f);
+	index[0] = 0; index[1] = 1; index[2] = 2;
+
+	std::size_t triangles = 1;
+	std::size_t vertices = 3;
+	for (int level = 0; level < iterations; level++) {
+		// The midpoints of triangle t get the indices vertices + 3t, + 3t + 1 and + 3t + 2, so
+		// going back to front its indices can be expanded in place like SerpinskyLevels::refine.
+		for (std::size_t t = triangles; t-- > 0;) {
+			std::uint32_t ia = index[3 * t + 0];
+			std::uint32_t ib = index[3 * t + 1];
+			std::uint32_t ic = index[3 * t + 2];
+
+			std::uint32_t ab = std::uint32_t(vertices + 3 * t);
+			std::uint32_t ac = ab + 1;
+			std::uint32_t bc = ab + 2;
+			verts[ab] = glm::vec3(half(glm::vec2(verts[ia]), glm::vec2(verts[ib])), 0.f);
+			verts[ac] = glm::vec3(half(glm::vec2(verts[ia]), glm::vec2(verts[ic])), 0.f);
+			verts[bc] = glm::vec3(half(glm::vec2(verts[ib]), glm::vec2(verts[ic])), 0.f);
+
+			std::uint32_t* children = index + 9 * t;
+			children[0] = ia; children[1] = ab; children[2] = ac;
+			children[3] = ab; children[4] = ib; children[5] = bc;
+			children[6] = ac; children[7] = bc; children[8] = ic;
+		}
+		vertices += 3 * triangles;
+		triangles *= 3;
+	}
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Geometry generators for the three fractal scenes.
+//
+// The recursive generators are the original implementations and are kept as
+// the reference that the faster engines are checked and benchmarked against
+// (see bench/). None of these functions touch OpenGL, so they can be used
+// without a window or context.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+// Colors
+glm::vec3 const RED = glm::vec3(1.f, 0.f, 0.f);
+glm::vec3 const GREEN = glm::vec3(0.f, 1.f, 0.f);
+glm::vec3 const BLUE = glm::vec3(0.f, 0.f, 1.f);
+glm::vec3 const BLACK = glm::vec3(0.f, 0.f, 0.f);
+glm::vec3 const YELLOW = glm::vec3(1.f, 1.f, 0.f);
+
+// Deepest Serpinsky triangle the iterative engine can build. 3^20 triangles is
+// already far more than fits in memory, this only bounds its fixed size stack.
+int const MAX_SERPINSKY_ITERATIONS = 20;
+
+
+// Random float between 0 and 1
+float randomFloat();
+
+// Helper function for entering points as data
+glm::vec3 point(std::vector<float> point);
+
+std::vector<float> rotatePoint(std::vector<float> point, std::vector<float> pivot, float angle);
+std::vector<float> pointOnLine(float alpha, std::vector<float> p, std::vector<float> q);
+std::vector<float> getVectorFromPoints(std::vector<float> p, std::vector<float> q);
+std::vector<float> getPointFromVector(std::vector<float> point, glm::vec3 vector);
+glm::vec3 squareDiamondPoint(std::vector<float> point, float factor);
+std::vector<float> midPoint(std::vector<float> vertex1, std::vector<float> vertex2);
+
+// Reference (recursive) generators. These append to the geometry they are given.
+void generateSerpinsky(std::vector<float> a, std::vector<float> b, std::vector<float> c, CPU_Geometry& triangle, int iterations);
+void generateSquareDiamond(CPU_Geometry& squareDiamond, int iterations, std::vector<std::vector<float>> initialPoints);
+void generateSnowflake(CPU_Geometry& snowflake, std::vector<float> startingPoint, std::vector<float> endingPoint, glm::vec3 color, int iterations);
+
+// Appends a random colour per vertex from rand(), so every call gives different
+// colours. The original, colorSerpinsky replaces it.
+void serpinskyAllColored(CPU_Geometry& triangle);
+void colorAllVerts(CPU_Geometry& cpuGeom, glm::vec3 color);
+
+
+// Counter-based colours for the Serpinsky triangle. A vertex gets a hash of which
+// vertex of which level it is. The index of a triangle within its level spells
+// out its path from the root in base 3, so this keys the colour to the triangle.
+// Regenerating a level gives it the same colours again, any range of vertices
+// can be coloured on its own, and there is no shared state like rand()'s. The
+// hash is 32 bit so shaders/serpinsky_color.glsl can compute the same on the GPU.
+std::uint32_t serpinskyHash(std::uint32_t x);
+glm::vec3 serpinskyColor(int level, std::uint64_t vertex);
+
+// Overwrites triangle.cols with the colours of vertices firstVertex onwards of
+// the given level, one per vertex in triangle.verts. Split into ranges over the
+// pool if there is one.
+void colorSerpinsky(CPU_Geometry& triangle, int level, std::uint64_t firstVertex = 0, ThreadPool* pool = nullptr);
+
+
+// One value in [0, 1] per vertex instead of a colour, to look up in a colour
+// map (see ColorMapTexture). These overwrite values.
+
+// Where the vertex's triangle comes among the triangles of its level, which is
+// the order of their paths from the root
+void serpinskyBranchValues(std::size_t vertices, std::vector<float>& values);
+
+// How deep the level of the vertex is, pointsPerLevel vertices to a level
+void squareDiamondDepthValues(std::size_t vertices, std::size_t pointsPerLevel, std::vector<float>& values);
+
+// How far along the line strip the vertex is by length, from the value from at
+// the first vertex to to at the last
+void arcLengthValues(const std::vector<glm::vec3>& verts, std::vector<float>& values, float from = 0.f, float to = 1.f);
+
+
+// Number of triangles in a Serpinsky triangle after the given number of iterations (3^iterations)
+std::size_t serpinskyTriangleCount(int iterations);
+
+// Writes the 3 * 3^iterations vertices of the Serpinsky triangle abc to out, in the
+// same order as generateSerpinsky. Uses a fixed size stack instead of recursion and
+// never allocates. iterations has to be 0 to MAX_SERPINSKY_ITERATIONS, that is
+// what the stack is sized for.
+void fillSerpinsky(glm::vec3* out, glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations);
+
+// Writes the 3 * 3^(iterations - split) vertices of one of the 3^split subtrees
+// the Serpinsky triangle abc has split levels down, the ones fillSerpinsky would
+// write starting at vertex subtree * 3 * 3^(iterations - split).
+void fillSerpinskySubtree(glm::vec3* out, glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations, int split, std::size_t subtree);
+
+// Replacement for generateSerpinsky. Overwrites triangle.verts with exactly
+// 3 * 3^iterations vertices, bit for bit the same as the recursive version.
+// Only allocates when triangle.verts does not already have the capacity.
+// iterations is clamped to MAX_SERPINSKY_ITERATIONS, here and in the parallel version.
+void generateSerpinskyIterative(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, int iterations);
+
+// Parallel generateSerpinskyIterative. The first splitIterations levels are split
+// into 3^splitIterations independent subtrees, each filled by one pool task
+// straight into its own range of triangle.verts, so no locking is needed.
+// The output is bit for bit the same as the serial version.
+void generateSerpinskyParallel(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, int iterations,
+	ThreadPool& pool, int splitIterations = 4);
+
+// Per-instance transforms for drawing the Serpinsky triangle abc at depth more
+// iterations than a base mesh of it. Each of the 3^depth entries is
+// (offset x, offset y, scale) such that offset + scale * p maps a point p of the
+// base mesh into that copy, in the same order generateSerpinsky emits them.
+void generateSerpinskyInstances(glm::vec2 a, glm::vec2 b, glm::vec2 c, int depth, std::vector<glm::vec3>& instances);
+
+// Number of segments on one side of the Koch snowflake after the given number
+// of iterations (4^iterations), each drawn as 2 vertices
+std::size_t snowflakeSegmentCount(int iterations);
+
+// Number of vertices in the square diamond after the given number of iterations
+std::size_t squareDiamondVertexCount(int iterations);
+
+// Number of distinct corners in a Serpinsky triangle after the given number of
+// iterations, (3^(iterations + 1) + 3) / 2
+std::size_t serpinskyVertexCount(int iterations);
+
+// Deepest level whose corners can all be told apart by a 32 bit index. Level 20
+// has (3^21 + 3) / 2, about 5.2 billion.
+int const MAX_INDEXED_SERPINSKY_ITERATIONS = 19;
+
+// Indexed version of generateSerpinskyIterative. Sub-triangles only ever touch at
+// their corners, so every edge is split exactly once per level and each corner is
+// emitted once into triangle.verts. indices holds 3 entries per triangle, in the
+// same order generateSerpinsky emits the triangles, and triangle.verts[indices[i]]
+// is bit for bit the i-th vertex of the non-indexed version. Indices are 32 bit,
+// so iterations is clamped to MAX_INDEXED_SERPINSKY_ITERATIONS.
+void generateSerpinskyIndexed(glm::vec2 a, glm::vec2 b, glm::vec2 c, CPU_Geometry& triangle, std::vector<std::uint32_t>& indices,
+	int iterations);
@@ -145,3 +145,177 @@ GLuint VertexBufferHandle::value() const {
 	return vboID;
 }
 
+
+ElementBufferHandle::ElementBufferHandle()
+	: eboID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenBuffers(1, &eboID);
+}
+
+
+ElementBufferHandle::ElementBufferHandle(ElementBufferHandle&& other) noexcept
+	: eboID(std::move(other.eboID))
+{
+	other.eboID = 0;
+}
+
+
+ElementBufferHandle& ElementBufferHandle::operator=(ElementBufferHandle&& other) noexcept {
+	std::swap(eboID, other.eboID);
+	return *this;
+}
+
+
+ElementBufferHandle::~ElementBufferHandle() {
+	glDeleteBuffers(1, &eboID);
+}
+
+
+ElementBufferHandle::operator GLuint() const {
+	return eboID;
+}
+
+
+GLuint ElementBufferHandle::value() const {
+	return eboID;
+}
+
+
+QueryHandle::QueryHandle()
+	: queryID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenQueries(1, &queryID);
+}
+
+
+QueryHandle::QueryHandle(QueryHandle&& other) noexcept
+	: queryID(std::move(other.queryID))
+{
+	other.queryID = 0;
+}
+
+
+QueryHandle& QueryHandle::operator=(QueryHandle&& other) noexcept {
+	std::swap(queryID, other.queryID);
+	return *this;
+}
+
+
+QueryHandle::~QueryHandle() {
+	glDeleteQueries(1, &queryID);
+}
+
+
+QueryHandle::operator GLuint() const {
+	return queryID;
+}
+
+
+GLuint QueryHandle::value() const {
+	return queryID;
+}
+
+
+FramebufferHandle::FramebufferHandle()
+	: framebufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::FramebufferHandle(FramebufferHandle&& other) noexcept
+	: framebufferID(std::move(other.framebufferID))
+{
+	other.framebufferID = 0;
+}
+
+
+FramebufferHandle& FramebufferHandle::operator=(FramebufferHandle&& other) noexcept {
+	std::swap(framebufferID, other.framebufferID);
+	return *this;
+}
+
+
+FramebufferHandle::~FramebufferHandle() {
+	glDeleteFramebuffers(1, &framebufferID);
+}
+
+
+FramebufferHandle::operator GLuint() const {
+	return framebufferID;
+}
+
+
+GLuint FramebufferHandle::value() const {
+	return framebufferID;
+}
+
+
+RenderbufferHandle::RenderbufferHandle()
+	: renderbufferID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::RenderbufferHandle(RenderbufferHandle&& other) noexcept
+	: renderbufferID(std::move(other.renderbufferID))
+{
+	other.renderbufferID = 0;
+}
+
+
+RenderbufferHandle& RenderbufferHandle::operator=(RenderbufferHandle&& other) noexcept {
+	std::swap(renderbufferID, other.renderbufferID);
+	return *this;
+}
+
+
+RenderbufferHandle::~RenderbufferHandle() {
+	glDeleteRenderbuffers(1, &renderbufferID);
+}
+
+
+RenderbufferHandle::operator GLuint() const {
+	return renderbufferID;
+}
+
+
+GLuint RenderbufferHandle::value() const {
+	return renderbufferID;
+}
+
+
+TextureHandle::TextureHandle()
+	: textureID(0) // Due to OpenGL syntax, we can't initial directly here, like we want.
+{
+	glGenTextures(1, &textureID);
+}
+
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept
+	: textureID(std::move(other.textureID))
+{
+	other.textureID = 0;
+}
+
+
+TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
+	std::swap(textureID, other.textureID);
+	return *this;
+}
+
+
+TextureHandle::~TextureHandle() {
+	glDeleteTextures(1, &textureID);
+}
+
+
+TextureHandle::operator GLuint() const {
+	return textureID;
+}
+
+
+GLuint TextureHandle::value() const {
+	return textureID;
+}
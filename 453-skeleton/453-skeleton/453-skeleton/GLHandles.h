@@ -154,3 +154,148 @@ private:
 	GLuint vboID;
 
 };
+
+
+// An RAII class for managing an element (index) buffer GLuint for OpenGL.
+class ElementBufferHandle {
+
+public:
+	ElementBufferHandle();
+
+	// Disallow copying
+	ElementBufferHandle(const ElementBufferHandle&) = delete;
+	ElementBufferHandle operator=(const ElementBufferHandle&) = delete;
+
+	// Allow moving
+	ElementBufferHandle(ElementBufferHandle&& other) noexcept;
+	ElementBufferHandle& operator=(ElementBufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~ElementBufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint eboID;
+
+};
+
+
+// An RAII class for managing a query object GLuint for OpenGL.
+class QueryHandle {
+
+public:
+	QueryHandle();
+
+	// Disallow copying
+	QueryHandle(const QueryHandle&) = delete;
+	QueryHandle operator=(const QueryHandle&) = delete;
+
+	// Allow moving
+	QueryHandle(QueryHandle&& other) noexcept;
+	QueryHandle& operator=(QueryHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~QueryHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint queryID;
+
+};
+
+
+// An RAII class for managing a framebuffer object GLuint for OpenGL.
+class FramebufferHandle {
+
+public:
+	FramebufferHandle();
+
+	// Disallow copying
+	FramebufferHandle(const FramebufferHandle&) = delete;
+	FramebufferHandle operator=(const FramebufferHandle&) = delete;
+
+	// Allow moving
+	FramebufferHandle(FramebufferHandle&& other) noexcept;
+	FramebufferHandle& operator=(FramebufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~FramebufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint framebufferID;
+
+};
+
+
+// An RAII class for managing a renderbuffer GLuint for OpenGL.
+class RenderbufferHandle {
+
+public:
+	RenderbufferHandle();
+
+	// Disallow copying
+	RenderbufferHandle(const RenderbufferHandle&) = delete;
+	RenderbufferHandle operator=(const RenderbufferHandle&) = delete;
+
+	// Allow moving
+	RenderbufferHandle(RenderbufferHandle&& other) noexcept;
+	RenderbufferHandle& operator=(RenderbufferHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~RenderbufferHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint renderbufferID;
+
+};
+
+
+// An RAII class for managing a texture GLuint for OpenGL.
+class TextureHandle {
+
+public:
+	TextureHandle();
+
+	// Disallow copying
+	TextureHandle(const TextureHandle&) = delete;
+	TextureHandle operator=(const TextureHandle&) = delete;
+
+	// Allow moving
+	TextureHandle(TextureHandle&& other) noexcept;
+	TextureHandle& operator=(TextureHandle&& other) noexcept;
+
+	// Clean up after ourselves.
+	~TextureHandle();
+
+
+	// Allow casting from this type into a GLuint
+	// This allows usage in situations where a function expects a GLuint
+	operator GLuint() const;
+	GLuint value() const;
+
+private:
+	GLuint textureID;
+
+};
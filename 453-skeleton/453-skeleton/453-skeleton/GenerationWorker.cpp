@@ -0,0 +1,258 @@
+#include "GenerationWorker.h"
+
+#include "AllocationCounter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+
+GenerationWorker::GenerationWorker(
+	glm::vec2 a, glm::vec2 b, glm::vec2 c, std::vector<std::vector<float>> squareDiamondPoints,
+	ThreadPool* pool, bool threaded, std::function<void()> published
+)
+	: triangles(a, b, c, pool)
+	, squareDiamond(squareDiamondPoints)
+	, snowflake1(a, b)
+	, snowflake2(b, c)
+	, snowflake3(c, a)
+	, published(published)
+	, threaded(threaded)
+{
+	if (threaded) thread = std::thread(&GenerationWorker::workerLoop, this);
+}
+
+
+GenerationWorker::~GenerationWorker() {
+	if (!thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		stopping = true;
+		requestCount++;
+	}
+	requested.notify_one();
+	thread.join();
+}
+
+
+void GenerationWorker::request(int scene, int iterations) {
+	if (!threaded) {
+		serve(scene, iterations);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		nextScene = scene;
+		nextIterations = iterations;
+		requestCount++;
+	}
+	requested.notify_one();
+}
+
+
+void GenerationWorker::setPrefetch(std::size_t budget, std::function<int(int)> maxIterations) {
+	this->budget = budget;
+	this->maxIterations = maxIterations;
+}
+
+
+GenerationWorker::PrefetchStats GenerationWorker::prefetchStats() {
+	std::lock_guard<std::mutex> lock(requestMutex);
+	return stats;
+}
+
+
+void GenerationWorker::workerLoop() {
+	while (true) {
+		int scene;
+		int iterations;
+		std::uint64_t seen;
+		{
+			std::unique_lock<std::mutex> lock(requestMutex);
+			requested.wait(lock, [this]() { return stopping || nextScene != 0 || !prefetchQueue.empty(); });
+			if (stopping) return;
+
+			scene = nextScene;
+			iterations = nextIterations;
+			nextScene = 0;
+			seen = requestCount;
+		}
+
+		// Whatever this turns out to be, a newer request makes it stale. The
+		// lambda fits std::function's own storage, so this doesn't allocate.
+		std::function<bool()> cancelled = [this, seen]() { return requestCount.load(std::memory_order_relaxed) != seen; };
+
+		// Requests first, prefetching only with nothing else to do
+		bool finished = (scene != 0) ? serve(scene, iterations, cancelled) : prefetchNext(cancelled);
+		if (!finished) {
+			std::lock_guard<std::mutex> lock(requestMutex);
+			stats.cancelled++;
+		}
+	}
+}
+
+
+bool GenerationWorker::serve(int scene, int iterations, const std::function<bool()>& cancelled) {
+	auto start = std::chrono::steady_clock::now();
+
+	GeneratedScene& result = results.back();
+	result.scene = scene;
+	result.iterations = iterations;
+
+	const PrefetchedLevel* level = findPrefetched(scene, iterations);
+	result.prefetched = (level != nullptr);
+	if (level != nullptr) {
+		// Copying into the slot reuses the storage it had the last time around
+		result.parts.resize(level->parts.size());
+		for (std::size_t i = 0; i < level->parts.size(); i++) {
+			result.parts[i].verts = level->parts[i].verts;
+			result.parts[i].cols = level->parts[i].cols;
+		}
+	}
+	else if (!build(scene, iterations, result.parts, cancelled)) {
+		// Never published, the slot is simply overwritten by the next one
+		return false;
+	}
+
+	result.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	results.publish();
+	if (published) published();
+
+	{
+		std::lock_guard<std::mutex> lock(requestMutex);
+		if (level != nullptr) stats.hits++;
+		else stats.misses++;
+	}
+
+	if (!threaded) return true;
+	current = { scene, iterations };
+	if (level == nullptr) keep(scene, iterations, result.parts);
+	planPrefetch();
+	return true;
+}
+
+
+bool GenerationWorker::build(int scene, int iterations, std::vector<CPU_Geometry>& parts, const std::function<bool()>& cancelled) {
+	// Copying into parts reuses whatever storage it already has
+	if (scene == 1) {
+		AllocationScope allocations("generate serpinsky");
+		if (!triangles.setLevel(iterations, cancelled)) return false;
+		parts.resize(1);
+		parts[0].verts = triangles.geometry().verts;
+		parts[0].cols = triangles.geometry().cols;
+	}
+	else if (scene == 2) {
+		AllocationScope allocations("generate square diamond");
+		if (!squareDiamond.setLevel(iterations, cancelled)) return false;
+		parts.resize(1);
+		parts[0].verts = squareDiamond.geometry().verts;
+		parts[0].cols = squareDiamond.geometry().cols;
+	}
+	else {
+		AllocationScope allocations("generate snowflake");
+		parts.resize(3);
+		SnowflakeLevels* sides[] = { &snowflake1, &snowflake2, &snowflake3 };
+		for (std::size_t i = 0; i < 3; i++) {
+			if (!sides[i]->setLevel(iterations, cancelled)) return false;
+			parts[i].verts = sides[i]->geometry().verts;
+			parts[i].cols = sides[i]->geometry().cols;
+		}
+	}
+	return true;
+}
+
+
+void GenerationWorker::planPrefetch() {
+	prefetchQueue.clear();
+	if (budget == 0) return;
+
+	// Going down is nearly free, so it goes first and going up leaves the scene
+	// one step further along for the next press
+	Level candidates[] = {
+		{ current.scene, current.iterations - 1 },
+		{ current.scene, current.iterations + 1 },
+		{ current.scene % 3 + 1, current.iterations },
+		{ (current.scene + 1) % 3 + 1, current.iterations },
+	};
+	for (const Level& level : candidates) {
+		if (level.iterations < 0 || level.iterations > maxIterations(level.scene)) continue;
+		if (findPrefetched(level.scene, level.iterations) != nullptr) continue;
+		prefetchQueue.push_back(level);
+	}
+}
+
+
+bool GenerationWorker::prefetchNext(const std::function<bool()>& cancelled) {
+	Level level = prefetchQueue.front();
+	prefetchQueue.erase(prefetchQueue.begin());
+
+	// A level has at most 4 times the vertices of the one below it. Don't
+	// spend the time on one that couldn't be kept anyway.
+	const PrefetchedLevel* below = findPrefetched(level.scene, level.iterations - 1);
+	if (below != nullptr && 4 * below->bytes > budget) {
+		std::lock_guard<std::mutex> lock(requestMutex);
+		stats.skipped++;
+		return true;
+	}
+
+	std::vector<CPU_Geometry> parts;
+	if (!build(level.scene, level.iterations, parts, cancelled)) return false;
+	keep(level.scene, level.iterations, std::move(parts));
+
+	std::lock_guard<std::mutex> lock(requestMutex);
+	stats.prefetched++;
+	return true;
+}
+
+
+void GenerationWorker::keep(int scene, int iterations, std::vector<CPU_Geometry> parts) {
+	std::size_t bytes = 0;
+	for (const CPU_Geometry& part : parts) {
+		bytes += sizeof(glm::vec3) * (part.verts.size() + part.cols.size());
+	}
+
+	std::size_t held = 0;
+	for (const PrefetchedLevel& level : prefetched) held += level.bytes;
+
+	// Make room by dropping the levels furthest from the last request, but
+	// only ones further away than this one
+	std::size_t evicted = 0;
+	int d = distance(scene, iterations);
+	while (held + bytes > budget && !prefetched.empty()) {
+		auto furthest = std::max_element(prefetched.begin(), prefetched.end(),
+			[this](const PrefetchedLevel& x, const PrefetchedLevel& y) {
+				return distance(x.scene, x.iterations) < distance(y.scene, y.iterations);
+			});
+		if (distance(furthest->scene, furthest->iterations) <= d) break;
+
+		held -= furthest->bytes;
+		prefetched.erase(furthest);
+		evicted++;
+	}
+
+	bool fits = (held + bytes <= budget);
+	if (fits) {
+		prefetched.push_back({ scene, iterations, std::move(parts), bytes });
+		held += bytes;
+	}
+
+	std::lock_guard<std::mutex> lock(requestMutex);
+	stats.evicted += evicted;
+	if (!fits) stats.skipped++;
+	stats.bytes = held;
+}
+
+
+int GenerationWorker::distance(int scene, int iterations) const {
+	// In key presses
+	return std::abs(iterations - current.iterations) + (scene != current.scene ? 1 : 0);
+}
+
+
+const GenerationWorker::PrefetchedLevel* GenerationWorker::findPrefetched(int scene, int iterations) const {
+	for (const PrefetchedLevel& level : prefetched) {
+		if (level.scene == scene && level.iterations == iterations) return &level;
+	}
+	return nullptr;
+}
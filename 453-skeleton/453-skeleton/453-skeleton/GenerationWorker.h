@@ -0,0 +1,154 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Generates the CPU scenes on a thread of its own.
+//
+// The render thread asks for a scene and level with request() and carries on
+// drawing what it already has. The worker steps its own copy of each scene to
+// that level and publishes the result through a TripleBuffer, which update()
+// picks up on the render thread for uploading. Only the newest request
+// matters, ones that arrive while the worker is busy replace each other.
+//
+// Whenever no request is waiting, the worker can prefetch: generate the levels
+// a key press away from the last request (n - 1 and n + 1 of the same scene, n
+// of the other scenes) and keep them, within a memory budget, so stepping to
+// one of them only costs a copy. A new request always goes first: whatever the
+// worker is generating, prefetch or older request, polls for newer requests
+// and is dropped as soon as one arrives, keeping the levels it stepped through.
+// The levels queued for prefetching are then replaced by the ones around it.
+//
+// Without a thread, request() generates before returning, so both ways can be
+// driven by the same code. There is no prefetching then.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "IncrementalFractals.h"
+#include "TripleBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool;
+
+
+struct GeneratedScene {
+	int scene = 0; // 0 before anything was generated
+	int iterations = 0;
+
+	// One for the Serpinsky triangle and the square diamond, one per side for the snowflake
+	std::vector<CPU_Geometry> parts;
+
+	double ms = 0.0;         // spent generating, or copying out of the prefetched levels
+	bool prefetched = false; // whether it was prefetched
+};
+
+
+class GenerationWorker {
+
+public:
+	// Corners of the triangle and snowflake, points of the square diamond. The
+	// pool splits up Serpinsky levels and must not be waited on by anyone else.
+	// published is called on the worker thread after every publish, to wake the
+	// render thread.
+	GenerationWorker(
+		glm::vec2 a, glm::vec2 b, glm::vec2 c, std::vector<std::vector<float>> squareDiamondPoints,
+		ThreadPool* pool, bool threaded = true, std::function<void()> published = {}
+	);
+
+	// Owns a thread, so no copying or moving
+	GenerationWorker(const GenerationWorker&) = delete;
+	GenerationWorker operator=(const GenerationWorker&) = delete;
+
+	// Lets the current generation finish, then joins the thread
+	~GenerationWorker();
+
+	// Public interface
+	void request(int scene, int iterations);
+
+	// Takes the newest finished scene, false if nothing finished since the last call
+	bool update() { return results.update(); }
+
+	// Valid until the next update()
+	const GeneratedScene& latest() const { return results.front(); }
+
+	// Keep up to budget bytes of prefetched levels, none above maxIterations(scene).
+	// A budget of 0 (the default) turns prefetching off. Call it before the
+	// first request(), the worker reads both without locking.
+	void setPrefetch(std::size_t budget, std::function<int(int)> maxIterations);
+
+	struct PrefetchStats {
+		std::size_t hits = 0;       // requests served from a prefetched level
+		std::size_t misses = 0;     // requests that had to be generated
+		std::size_t prefetched = 0; // levels generated ahead of time
+		std::size_t evicted = 0;    // dropped to make room for closer ones
+		std::size_t skipped = 0;    // never generated or kept because they wouldn't fit
+		std::size_t cancelled = 0;  // prefetches and requests dropped for a newer request
+		std::size_t bytes = 0;      // held right now
+	};
+	PrefetchStats prefetchStats();
+
+private:
+	struct Level {
+		int scene;
+		int iterations;
+	};
+
+	struct PrefetchedLevel {
+		int scene;
+		int iterations;
+		std::vector<CPU_Geometry> parts;
+		std::size_t bytes;
+	};
+
+	SerpinskyLevels triangles;
+	SquareDiamondLevels squareDiamond;
+	SnowflakeLevels snowflake1;
+	SnowflakeLevels snowflake2;
+	SnowflakeLevels snowflake3;
+
+	TripleBuffer<GeneratedScene> results;
+	std::function<void()> published;
+	bool threaded;
+
+	// The request waiting for the worker, scene 0 if none
+	std::mutex requestMutex;
+	std::condition_variable requested;
+	int nextScene = 0;
+	int nextIterations = 0;
+	bool stopping = false;
+
+	// Bumped by every request and by stopping, so generation can tell it is stale
+	std::atomic<std::uint64_t> requestCount{ 0 };
+
+	// Also guarded by requestMutex
+	PrefetchStats stats;
+
+	// Set before the first request
+	std::size_t budget = 0;
+	std::function<int(int)> maxIterations;
+
+	// Only touched by the worker
+	std::vector<PrefetchedLevel> prefetched;
+	std::vector<Level> prefetchQueue; // next one first
+	Level current{ 0, 0 };            // the last request, prefetching centers on it
+
+	std::thread thread;
+
+	void workerLoop();
+	// Both give up, returning false, once cancelled returns true
+	bool serve(int scene, int iterations, const std::function<bool()>& cancelled = {});
+	bool build(int scene, int iterations, std::vector<CPU_Geometry>& parts, const std::function<bool()>& cancelled);
+
+	void planPrefetch();
+	bool prefetchNext(const std::function<bool()>& cancelled);
+	void keep(int scene, int iterations, std::vector<CPU_Geometry> parts);
+	int distance(int scene, int iterations) const;
+	const PrefetchedLevel* findPrefetched(int scene, int iterations) const;
+};
@@ -1,20 +1,205 @@
 #include "Geometry.h"
 
+#include <cstring>
 #include <utility>
 
 
-GPU_Geometry::GPU_Geometry()
+GPU_Geometry::GPU_Geometry(VertexFormat format, BufferLayout layout, UploadMode mode)
 	: vao()
-	, vertBuffer(0, 3, GL_FLOAT)
-	, colBuffer(1, 3, GL_FLOAT)
-{}
+	, format(format)
+	, layout(layout)
+	, vertBuffer()
+	, colBuffer()
+{
+	bool compact = (format == VertexFormat::Compact);
+
+	// The attributes below point at the plain buffers until the first upload
+	// points them at a stream
+	if (mode == UploadMode::Streaming) {
+		vertStream = std::make_unique<StreamBuffer>();
+		if (layout == BufferLayout::Split) colStream = std::make_unique<StreamBuffer>();
+	}
+
+	vertBuffer.bind();
+	if (layout == BufferLayout::Interleaved) {
+		if (compact) applyVertexLayout<CompactVertex>();
+		else applyVertexLayout<FloatVertex>();
+		return;
+	}
+
+	if (compact) applyVertexLayout<CompactPosition>();
+	else applyVertexLayout<FloatPosition>();
+
+	colBuffer.bind();
+	if (compact) applyVertexLayout<CompactColor>();
+	else applyVertexLayout<FloatColor>();
+}
+
+
+void GPU_Geometry::bind() {
+	vao.bind();
+
+	// Whatever is drawn next reads the last uploads
+	if (vertStream) vertStream->used();
+	if (colStream) colStream->used();
+}
+
+
+void GPU_Geometry::setGeometry(const CPU_Geometry& geom) {
+	if (layout == BufferLayout::Split) {
+		setVerts(geom.verts);
+		setCols(geom.cols);
+		return;
+	}
+
+	if (format == VertexFormat::Compact) {
+		storePositions(staging<CompactVertex>(), geom.verts);
+		storeColors(staging<CompactVertex>(), geom.cols);
+		upload(vertBuffer, vertStream.get(), staging<CompactVertex>());
+	}
+	else {
+		storePositions(staging<FloatVertex>(), geom.verts);
+		storeColors(staging<FloatVertex>(), geom.cols);
+		upload(vertBuffer, vertStream.get(), staging<FloatVertex>());
+	}
+}
 
 
 void GPU_Geometry::setVerts(const std::vector<glm::vec3>& verts) {
-	vertBuffer.uploadData(sizeof(glm::vec3) * verts.size(), verts.data(), GL_STATIC_DRAW);
+	if (layout == BufferLayout::Interleaved) {
+		// The colours already staged go up again with the new positions
+		if (format == VertexFormat::Compact) {
+			storePositions(staging<CompactVertex>(), verts);
+			upload(vertBuffer, vertStream.get(), staging<CompactVertex>());
+		}
+		else {
+			storePositions(staging<FloatVertex>(), verts);
+			upload(vertBuffer, vertStream.get(), staging<FloatVertex>());
+		}
+	}
+	else if (format == VertexFormat::Compact) {
+		storePositions(staging<CompactPosition>(), verts);
+		upload(vertBuffer, vertStream.get(), staging<CompactPosition>());
+	}
+	else {
+		// Already in the FloatPosition layout
+		static_assert(sizeof(FloatPosition) == sizeof(glm::vec3), "FloatPosition has to match glm::vec3");
+		upload<FloatPosition>(vertBuffer, vertStream.get(), verts.data(), verts.size());
+	}
 }
 
 
 void GPU_Geometry::setCols(const std::vector<glm::vec3>& cols) {
-	colBuffer.uploadData(sizeof(glm::vec3) * cols.size(), cols.data(), GL_STATIC_DRAW);
+	if (layout == BufferLayout::Interleaved) {
+		if (format == VertexFormat::Compact) {
+			storeColors(staging<CompactVertex>(), cols);
+			upload(vertBuffer, vertStream.get(), staging<CompactVertex>());
+		}
+		else {
+			storeColors(staging<FloatVertex>(), cols);
+			upload(vertBuffer, vertStream.get(), staging<FloatVertex>());
+		}
+	}
+	else if (format == VertexFormat::Compact) {
+		storeColors(staging<CompactColor>(), cols);
+		upload(colBuffer, colStream.get(), staging<CompactColor>());
+	}
+	else {
+		upload<FloatColor>(colBuffer, colStream.get(), cols.data(), cols.size());
+	}
+}
+
+
+void GPU_Geometry::disableCols() {
+	vao.bind();
+	glDisableVertexAttribArray(1);
+}
+
+
+void GPU_Geometry::setValues(const std::vector<float>& values) {
+	// Streaming points the attribute at the values as part of uploading them,
+	// otherwise the colour layout from the constructor has to be replaced here
+	if (colStream == nullptr) {
+		vao.bind();
+		colBuffer.bind();
+		applyVertexLayout<CompactValue>();
+	}
+
+	std::vector<CompactValue>& compactValues = staging<CompactValue>();
+	compactValues.resize(values.size());
+	for (std::size_t i = 0; i < values.size(); i++) store(compactValues[i].value, values[i]);
+	upload(colBuffer, colStream.get(), compactValues);
+}
+
+
+std::size_t GPU_Geometry::valueBytes() const {
+	return sizeof(CompactValue);
+}
+
+
+std::size_t GPU_Geometry::vertexBytes() const {
+	// The split layouts add up to the same
+	return (format == VertexFormat::Compact) ? sizeof(CompactVertex) : sizeof(FloatVertex);
+}
+
+
+template <typename Vertex>
+void GPU_Geometry::upload(VertexBuffer& buffer, StreamBuffer* stream, const void* vertices, std::size_t count) {
+	GLsizeiptr size = GLsizeiptr(sizeof(Vertex) * count);
+
+	if (stream == nullptr) {
+		buffer.uploadData(size, vertices, GL_STATIC_DRAW);
+		return;
+	}
+
+	GLintptr offset = 0;
+	std::memcpy(stream->map(size, offset), vertices, std::size_t(size));
+	stream->unmap();
+
+	// The attribute pointers of this vertex array move to the new data
+	vao.bind();
+	stream->bind();
+	applyVertexLayout<Vertex>(offset);
+}
+
+
+void GPU_Geometry::setInstances(const std::vector<glm::vec3>& instances) {
+	if (instanceBuffer == nullptr) {
+		// The attribute setup is recorded in whichever VAO is bound
+		vao.bind();
+		instanceBuffer = std::make_unique<VertexBuffer>(2, 3, GL_FLOAT, GL_FALSE, 1);
+		instanceBuffer->setShrinkPolicy(shrink);
+	}
+	instanceBuffer->uploadData(sizeof(glm::vec3) * instances.size(), instances.data(), GL_STATIC_DRAW);
+}
+
+
+void GPU_Geometry::setShrinkPolicy(ShrinkPolicy policy) {
+	shrink = policy;
+	vertBuffer.setShrinkPolicy(policy);
+	colBuffer.setShrinkPolicy(policy);
+	if (instanceBuffer != nullptr) instanceBuffer->setShrinkPolicy(policy);
+}
+
+
+void GPU_Geometry::setIndices(const std::vector<std::uint32_t>& indices, std::size_t vertexCount) {
+	// The element array binding is part of the VAO
+	vao.bind();
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+	if (vertexCount <= 0x10000) {
+		narrowed.assign(indices.begin(), indices.end());
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(std::uint16_t) * narrowed.size(), narrowed.data(), GL_STATIC_DRAW);
+		type = GL_UNSIGNED_SHORT;
+	}
+	else {
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(std::uint32_t) * indices.size(), indices.data(), GL_STATIC_DRAW);
+		type = GL_UNSIGNED_INT;
+	}
+	this->indices = GLsizei(indices.size());
+}
+
+
+std::size_t GPU_Geometry::indexBytes() const {
+	return std::size_t(indices) * (type == GL_UNSIGNED_SHORT ? sizeof(std::uint16_t) : sizeof(std::uint32_t));
 }
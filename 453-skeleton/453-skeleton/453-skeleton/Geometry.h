@@ -6,12 +6,18 @@
 // similar classes with the needed functionality
 //------------------------------------------------------------------------------
 
+#include "GLHandles.h"
+#include "StreamBuffer.h"
 #include "VertexArray.h"
 #include "VertexBuffer.h"
+#include "VertexLayout.h"
 
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
+#include <memory>
+#include <tuple>
 #include <vector>
 
 
@@ -22,23 +28,127 @@ struct CPU_Geometry {
 };
 
 
-// VAO and two VBOs for storing vertices and colours, respectively
+// How GPU_Geometry stores vertices and colours on the GPU
+enum class VertexFormat {
+	Float,   // vec3 positions and vec3 colours as given, 24 bytes per vertex
+	Compact  // x and y as 16 bit signed normalized and RGBA8 colours, 8 bytes per vertex.
+	         // Positions have to be in [-1, 1], which everything in clip space is.
+};
+
+// Whether positions and colours live in a buffer each, or interleaved in one
+enum class BufferLayout {
+	Split,
+	Interleaved
+};
+
+// Static uploads replace the buffer's storage every time. Streaming ones go
+// through a StreamBuffer ring instead, for geometry that is replaced often.
+enum class UploadMode {
+	Static,
+	Streaming
+};
+
+
+// VAO and two VBOs for storing vertices and colours, respectively, or one VBO
+// with both interleaved. The attribute setup for each combination comes from
+// the vertex structs in VertexLayout.h.
+//
+// With VertexFormat::Compact the vertices are converted when they are uploaded,
+// the shaders see the same vec3 attributes either way (z is filled in as 0).
+// setGeometry uploads positions and colours together, which for the
+// interleaved layout is a single upload; setVerts and setCols on their own
+// reupload the whole interleaved buffer.
+//
+// With UploadMode::Streaming positions and colours come from StreamBuffers (one
+// per buffer of the layout) and the attributes are pointed at wherever the
+// last upload landed. Uploading then never waits for draws of older data.
+//
+// Optionally a third, per-instance VBO at location 2 for drawing the same
+// vertices many times with glDrawArraysInstanced. It is only created the first
+// time setInstances is called, so geometry that isn't instanced doesn't get
+// an enabled attribute without data behind it.
+//
+// Also optionally an index buffer, for drawing with glDrawElements. Indices are
+// stored as 16 bit when every vertex can be addressed with them, and as 32 bit
+// otherwise; indexType() says which one to pass to glDrawElements.
 class GPU_Geometry {
 
 public:
-	GPU_Geometry();
+	GPU_Geometry(VertexFormat format = VertexFormat::Float, BufferLayout layout = BufferLayout::Split,
+		UploadMode mode = UploadMode::Static);
 
 	// Public interface
-	void bind() { vao.bind(); }
+	void bind();
 
+	void setGeometry(const CPU_Geometry& geom);
 	void setVerts(const std::vector<glm::vec3>& verts);
 	void setCols(const std::vector<glm::vec3>& cols);
 
+	// Stops reading colours from location 1, for shaders that work them out
+	// themselves like shaders/serpinsky.vert. Call setVerts instead of
+	// setGeometry after this, then no colours are uploaded at all. Interleaved
+	// layouts keep room for them in every vertex anyway.
+	void disableCols();
+
+	// One value in [0, 1] per vertex in place of its colour, at location 1, to
+	// look the colour up in a colour map with shaders/colormap.vert. Stored as
+	// 16 bit fixed point with either vertex format. Only the split layout has a
+	// buffer to put them in. Use setVerts for positions
+	// after this, setGeometry and setCols would point location 1 back at colours.
+	void setValues(const std::vector<float>& values);
+
+	// Bytes per value on the GPU
+	std::size_t valueBytes() const;
+
+	// Bytes of position and colour per vertex on the GPU
+	std::size_t vertexBytes() const;
+
+	// One (offset x, offset y, scale) per instance, see shaders/instanced.vert
+	void setInstances(const std::vector<glm::vec3>& instances);
+
+	// For every buffer of this geometry, see VertexBuffer
+	void setShrinkPolicy(ShrinkPolicy policy);
+
+	// vertexCount is how many vertices the indices refer to
+	void setIndices(const std::vector<std::uint32_t>& indices, std::size_t vertexCount);
+
+	GLsizei indexCount() const { return indices; }
+	GLenum indexType() const { return type; }
+	// Size of the uploaded indices in bytes
+	std::size_t indexBytes() const;
+
 private:
 	// note: due to how OpenGL works, vao needs to be 
 	// defined and initialized before the vertex buffers
 	VertexArray vao;
 
-	VertexBuffer vertBuffer;
-	VertexBuffer colBuffer;
+	VertexFormat format;
+	BufferLayout layout;
+	VertexBuffer vertBuffer; // everything when interleaved
+	VertexBuffer colBuffer;  // unused when interleaved
+	std::unique_ptr<StreamBuffer> vertStream; // instead of vertBuffer when streaming
+	std::unique_ptr<StreamBuffer> colStream;  // instead of colBuffer when streaming
+	std::unique_ptr<VertexBuffer> instanceBuffer;
+	ShrinkPolicy shrink = ShrinkPolicy::Quarter;
+
+	ElementBufferHandle indexBuffer;
+	GLsizei indices = 0;
+	GLenum type = GL_UNSIGNED_INT;
+	std::vector<std::uint16_t> narrowed; // kept so 16 bit uploads don't allocate every time
+
+	// Converted vertices waiting to be uploaded, one vector per layout that needs one
+	std::tuple<std::vector<FloatVertex>, std::vector<CompactVertex>, std::vector<CompactPosition>, std::vector<CompactColor>,
+		std::vector<CompactValue>> staged;
+
+	template <typename Vertex>
+	std::vector<Vertex>& staging() { return std::get<std::vector<Vertex>>(staged); }
+
+	// Uploads count vertices of layout Vertex to buffer, or to stream when there is one
+	template <typename Vertex>
+	void upload(VertexBuffer& buffer, StreamBuffer* stream, const void* vertices, std::size_t count);
+
+	template <typename Vertex>
+	void upload(VertexBuffer& buffer, StreamBuffer* stream, const std::vector<Vertex>& vertices) {
+		upload<Vertex>(buffer, stream, vertices.data(), vertices.size());
+	}
 };
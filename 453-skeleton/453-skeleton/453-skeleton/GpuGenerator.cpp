@@ -0,0 +1,124 @@
+#include "GpuGenerator.h"
+
+#include "Fractals.h"
+
+#include <vector>
+
+
+namespace {
+	// Position and colour, both vec3
+	GLsizei const VERTEX_SIZE = GLsizei(2 * sizeof(glm::vec3));
+}
+
+
+GpuFractalGenerator::FeedbackBuffer::FeedbackBuffer()
+	: vao()
+	, buffer()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, VERTEX_SIZE, (void*)sizeof(glm::vec3));
+	glEnableVertexAttribArray(1);
+}
+
+
+GpuFractalGenerator::GpuFractalGenerator()
+	: serpinskyStep("shaders/feedback.vert", "shaders/serpinsky_step.geom", { "outPos", "outCol" })
+	, kochStep("shaders/feedback.vert", "shaders/koch_step.geom", { "outPos", "outCol" })
+{}
+
+
+void GpuFractalGenerator::generateSerpinsky(glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations) {
+	glm::vec3 const corners[] = {
+		glm::vec3(a, 0.f), serpinskyColor(0, 0),
+		glm::vec3(b, 0.f), serpinskyColor(0, 1),
+		glm::vec3(c, 0.f), serpinskyColor(0, 2)
+	};
+	seed(corners, 3);
+	mode = GL_TRIANGLES;
+
+	// Each pass colours the level it writes, the same as colorSerpinsky would
+	serpinskyStep.use();
+	for (int level = 0; level < iterations; level++) {
+		glUniform1ui(serpinskyStep.uniformLocation("level"), GLuint(level + 1));
+		step(serpinskyStep, 3 * count);
+	}
+}
+
+
+void GpuFractalGenerator::generateSnowflake(glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations) {
+	glm::vec3 const sides[] = {
+		glm::vec3(a, 0.f), BLUE, glm::vec3(b, 0.f), BLUE,
+		glm::vec3(b, 0.f), BLUE, glm::vec3(c, 0.f), BLUE,
+		glm::vec3(c, 0.f), BLUE, glm::vec3(a, 0.f), BLUE
+	};
+	seed(sides, 6);
+	mode = GL_LINES;
+
+	kochStep.use();
+	for (int level = 0; level < iterations; level++) {
+		step(kochStep, 4 * count);
+	}
+}
+
+
+void GpuFractalGenerator::draw() const {
+	buffers[front].vao.bind();
+	glDrawArrays(mode, 0, count);
+}
+
+
+void GpuFractalGenerator::readVerts(std::vector<glm::vec3>& verts, std::vector<glm::vec3>& cols) const {
+	std::vector<glm::vec3> interleaved(2 * std::size_t(count));
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[front].buffer);
+	glGetBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(count) * VERTEX_SIZE, interleaved.data());
+
+	verts.resize(count);
+	cols.resize(count);
+	for (GLsizei i = 0; i < count; i++) {
+		verts[i] = interleaved[2 * i + 0];
+		cols[i] = interleaved[2 * i + 1];
+	}
+}
+
+
+void GpuFractalGenerator::seed(const glm::vec3* data, GLsizei vertices) {
+	front = 0;
+	count = vertices;
+	reserve(buffers[front], vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, buffers[front].buffer);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(vertices) * VERTEX_SIZE, data);
+}
+
+
+void GpuFractalGenerator::step(const FeedbackProgram& program, GLsizei verticesOut) {
+	FeedbackBuffer& src = buffers[front];
+	FeedbackBuffer& dst = buffers[1 - front];
+	reserve(dst, verticesOut);
+
+	glEnable(GL_RASTERIZER_DISCARD);
+	src.vao.bind();
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, dst.buffer);
+
+	glBeginTransformFeedback(mode);
+	glDrawArrays(mode, 0, count);
+	glEndTransformFeedback();
+
+	glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+	glDisable(GL_RASTERIZER_DISCARD);
+
+	front = 1 - front;
+	count = verticesOut;
+}
+
+
+void GpuFractalGenerator::reserve(FeedbackBuffer& buffer, GLsizei vertices) {
+	GLsizeiptr size = GLsizeiptr(vertices) * VERTEX_SIZE;
+	if (size <= buffer.capacity) return;
+
+	// Grow to the next level's size at least, the passes overwrite whatever is there
+	glBindBuffer(GL_ARRAY_BUFFER, buffer.buffer);
+	glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_COPY);
+	buffer.capacity = size;
+}
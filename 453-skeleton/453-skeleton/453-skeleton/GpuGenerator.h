@@ -0,0 +1,66 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Fractal generation on the GPU with transform feedback.
+//
+// Every level is one draw call that runs a geometry shader over the previous
+// level and captures what it emits into a second buffer, with rasterization
+// turned off. The two buffers then swap roles, so after n passes the last
+// written buffer holds level n and can be drawn directly without ever going
+// through CPU memory. Only needs OpenGL 3.3 core.
+//------------------------------------------------------------------------------
+
+#include "FeedbackProgram.h"
+#include "GLHandles.h"
+#include "VertexArray.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+class GpuFractalGenerator {
+
+public:
+	GpuFractalGenerator();
+
+	// Same corners, vertex order and vertex count as generateSerpinskyIterative.
+	// Colours are serpinskyColor's, hashed on the GPU.
+	void generateSerpinsky(glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations);
+
+	// All three sides of the snowflake as GL_LINES, the same vertices and colours
+	// as generateSnowflakeBreadthFirst for each side, one after the other
+	void generateSnowflake(glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations);
+
+	// Draws whatever was generated last
+	void draw() const;
+
+	GLsizei vertexCount() const { return count; }
+
+	// Copies the generated vertices back, only meant for comparing against the CPU
+	void readVerts(std::vector<glm::vec3>& verts, std::vector<glm::vec3>& cols) const;
+
+private:
+	// Interleaved position + colour, the layout the feedback programs capture
+	struct FeedbackBuffer {
+		FeedbackBuffer();
+
+		VertexArray vao;
+		VertexBufferHandle buffer;
+		GLsizeiptr capacity = 0;
+	};
+
+	FeedbackProgram serpinskyStep;
+	FeedbackProgram kochStep;
+
+	FeedbackBuffer buffers[2];
+	int front = 0; // which buffer holds the last generated level
+
+	GLenum mode = GL_TRIANGLES;
+	GLsizei count = 0;
+
+	void seed(const glm::vec3* data, GLsizei vertices);
+	void step(const FeedbackProgram& program, GLsizei verticesOut);
+	void reserve(FeedbackBuffer& buffer, GLsizei vertices);
+};
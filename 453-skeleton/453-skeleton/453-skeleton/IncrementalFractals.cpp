@@ -0,0 +1,190 @@
+#include "IncrementalFractals.h"
+
+#include "Fractals.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+bool IncrementalFractal::setLevel(int iterations, const std::function<bool()>& cancelled) {
+	iterations = std::max(iterations, 0);
+	if (iterations == current && !stale) return true;
+
+	this->cancelled = &cancelled;
+	bool finished = true;
+	while (finished && current < iterations) {
+		finished = !cancelRequested() && refine();
+		if (finished) current++;
+		stale = true;
+	}
+	while (finished && current > iterations) {
+		finished = !cancelRequested();
+		if (finished) {
+			decimate();
+			current--;
+		}
+		stale = true;
+	}
+	finished = finished && !cancelRequested();
+	this->cancelled = nullptr;
+
+	if (!finished) return false;
+	levelChanged();
+	stale = false;
+	return true;
+}
+
+
+//------------------------------------------------------------------------------
+
+
+SerpinskyLevels::SerpinskyLevels(glm::vec2 a, glm::vec2 b, glm::vec2 c, ThreadPool* pool)
+	: pool(pool)
+{
+	geom.verts = { glm::vec3(a, 0.f), glm::vec3(b, 0.f), glm::vec3(c, 0.f) };
+	levelChanged();
+}
+
+
+bool SerpinskyLevels::refine() {
+	std::size_t triangles = geom.verts.size() / 3;
+
+	if (pool != nullptr) {
+		scratch.clear();
+		scratch.resize(9 * triangles);
+		const glm::vec3* src = geom.verts.data();
+		glm::vec3* dst = scratch.data();
+
+		std::size_t chunk = triangles / (4 * pool->size()) + 1;
+		for (std::size_t begin = 0; begin < triangles; begin += chunk) {
+			std::size_t end = std::min(begin + chunk, triangles);
+			pool->submit([=]() {
+				for (std::size_t t = begin; t < end; t++) {
+					if (t % 4096 == 0 && cancelRequested()) return;
+					fillSerpinsky(dst + 9 * t, glm::vec2(src[3 * t]), glm::vec2(src[3 * t + 1]), glm::vec2(src[3 * t + 2]), 1);
+				}
+			});
+		}
+		pool->wait();
+
+		// Some ranges may have been skipped, the level stays as it was then
+		if (cancelRequested()) return false;
+		geom.verts.swap(scratch);
+		return true;
+	}
+
+	geom.verts.resize(9 * triangles);
+	glm::vec3* verts = geom.verts.data();
+
+	// Triangle t is read from [3t, 3t + 3) and written to [9t, 9t + 9), which only
+	// overlaps triangles after it, and those have already been expanded.
+	for (std::size_t t = triangles; t-- > 0;) {
+		glm::vec2 a(verts[3 * t + 0]);
+		glm::vec2 b(verts[3 * t + 1]);
+		glm::vec2 c(verts[3 * t + 2]);
+		fillSerpinsky(verts + 9 * t, a, b, c, 1);
+	}
+	return true;
+}
+
+
+void SerpinskyLevels::decimate() {
+	std::size_t triangles = geom.verts.size() / 9;
+	glm::vec3* verts = geom.verts.data();
+
+	// The children of abc are ade, dbf and efc
+	for (std::size_t t = 0; t < triangles; t++) {
+		verts[3 * t + 0] = verts[9 * t + 0];
+		verts[3 * t + 1] = verts[9 * t + 4];
+		verts[3 * t + 2] = verts[9 * t + 8];
+	}
+	geom.verts.resize(3 * triangles);
+}
+
+
+void SerpinskyLevels::levelChanged() {
+	colorSerpinsky(geom, current, 0, pool);
+}
+
+
+//------------------------------------------------------------------------------
+
+
+SquareDiamondLevels::SquareDiamondLevels(std::vector<std::vector<float>> initialPoints)
+	: initialPoints(initialPoints)
+{
+	generateSquareDiamond(geom, 0, initialPoints);
+}
+
+
+bool SquareDiamondLevels::refine() {
+	// generateSquareDiamond halves the factor every iteration, starting at 0.5
+	float factor = std::ldexp(1.f, -(current + 1));
+
+	for (const std::vector<float>& p : initialPoints) geom.verts.push_back(squareDiamondPoint(p, factor));
+	geom.cols.insert(geom.cols.end(), 5, BLUE);
+	geom.cols.insert(geom.cols.end(), 5, RED);
+	return true;
+}
+
+
+void SquareDiamondLevels::decimate() {
+	geom.verts.resize(geom.verts.size() - initialPoints.size());
+	geom.cols.resize(geom.cols.size() - 10);
+}
+
+
+//------------------------------------------------------------------------------
+
+
+SnowflakeLevels::SnowflakeLevels(glm::vec2 start, glm::vec2 end) {
+	buffers.x[front] = { start.x, end.x };
+	buffers.y[front] = { start.y, end.y };
+	levelChanged();
+}
+
+
+bool SnowflakeLevels::refine() {
+	std::size_t n = segments();
+	int back = 1 - front;
+
+	buffers.x[back].clear();
+	buffers.y[back].clear();
+	buffers.x[back].resize(4 * n + 1);
+	buffers.y[back].resize(4 * n + 1);
+
+	// A range of segments writes the points of its children, and the first point
+	// of the next range, which that range writes again the same. Between ranges
+	// the step can be given up, front still has the level as it was.
+	std::size_t const RANGE = std::size_t(1) << 16;
+	const float* x = buffers.x[front].data();
+	const float* y = buffers.y[front].data();
+	for (std::size_t begin = 0; begin < n; begin += RANGE) {
+		if (cancelRequested()) return false;
+		std::size_t count = std::min(RANGE, n - begin);
+		kochSubdivide(x + begin, y + begin, count, buffers.x[back].data() + 4 * begin, buffers.y[back].data() + 4 * begin, buffers.path);
+	}
+	front = back;
+	return true;
+}
+
+
+void SnowflakeLevels::decimate() {
+	std::size_t n = segments() / 4;
+	std::vector<float>& x = buffers.x[front];
+	std::vector<float>& y = buffers.y[front];
+
+	// Every parent point is the first point of its 4 children
+	for (std::size_t i = 0; i <= n; i++) {
+		x[i] = x[4 * i];
+		y[i] = y[4 * i];
+	}
+	x.resize(n + 1);
+	y.resize(n + 1);
+}
+
+
+void SnowflakeLevels::levelChanged() {
+	snowflakeSegments(buffers.x[front].data(), buffers.y[front].data(), segments(), current, geom);
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Fractals that remember their last level.
+//
+// Level n + 1 of every scene is a deterministic refinement of level n, and
+// level n - 1 can be read back out of level n. So instead of clearing and
+// regenerating from level 0 on every arrow key, these keep the current
+// geometry around and step it one level at a time, which costs O(output)
+// per step with no recursion.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+#include "Koch.h"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+
+class IncrementalFractal {
+
+public:
+	virtual ~IncrementalFractal() = default;
+
+	// Public interface
+
+	// cancelled is polled between steps and during the long ones, also from pool
+	// threads. Once it returns true, setLevel stops at whichever level it got to
+	// and returns false. The geometry is out of date then, until a later
+	// setLevel finishes.
+	bool setLevel(int iterations, const std::function<bool()>& cancelled = {});
+
+	int level() const { return current; }
+	const CPU_Geometry& geometry() const { return geom; }
+
+protected:
+	CPU_Geometry geom;
+	int current = 0;
+
+	// current -> current + 1 and current -> current - 1. refine may return false
+	// instead when it was cancelled, with the geometry still at current.
+	virtual bool refine() = 0;
+	virtual void decimate() = 0;
+
+	// Called once after setLevel has taken all its steps
+	virtual void levelChanged() {}
+
+	// For refine to poll
+	bool cancelRequested() const { return cancelled != nullptr && *cancelled && (*cancelled)(); }
+
+private:
+	const std::function<bool()>* cancelled = nullptr; // only during setLevel
+	bool stale = false; // stepped since the last levelChanged
+};
+
+
+// Each triangle becomes its three children. Without a pool that happens in
+// place, back to front so no triangle is overwritten before it is read, and
+// can't be cancelled. With a pool, ranges of triangles are expanded in
+// parallel into a second buffer, which is dropped if the step is cancelled.
+// Decimation keeps the outer corners of every group of three children.
+class SerpinskyLevels : public IncrementalFractal {
+
+public:
+	SerpinskyLevels(glm::vec2 a, glm::vec2 b, glm::vec2 c, ThreadPool* pool = nullptr);
+
+private:
+	ThreadPool* pool;
+	std::vector<glm::vec3> scratch;
+
+	bool refine() override;
+	void decimate() override;
+	void levelChanged() override;
+};
+
+
+// Every level appends the square and diamond at the next half size
+class SquareDiamondLevels : public IncrementalFractal {
+
+public:
+	SquareDiamondLevels(std::vector<std::vector<float>> initialPoints);
+
+private:
+	std::vector<std::vector<float>> initialPoints;
+
+	bool refine() override;
+	void decimate() override;
+};
+
+
+// One side of the snowflake. The polyline is kept in KochBuffers so refining is
+// a kochSubdivide pass over ranges of segments, and decimating keeps every 4th point.
+class SnowflakeLevels : public IncrementalFractal {
+
+public:
+	SnowflakeLevels(glm::vec2 start, glm::vec2 end);
+
+private:
+	KochBuffers buffers;
+	int front = 0; // which of the ping-pong buffers holds the current polyline
+
+	std::size_t segments() const { return buffers.x[front].size() - 1; }
+
+	bool refine() override;
+	void decimate() override;
+	void levelChanged() override;
+};
@@ -0,0 +1,276 @@
+#define _USE_MATH_DEFINES
+#include "Koch.h"
+
+#include "Fractals.h"
+
+#include <math.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KOCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(KOCH_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define KOCH_SSE2 1
+#endif
+
+// GCC and Clang only emit AVX2 instructions in functions that ask for them,
+// MSVC lets any function use the intrinsics.
+#if defined(KOCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define KOCH_AVX2 1
+#define KOCH_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(KOCH_X86) && defined(_MSC_VER)
+#define KOCH_AVX2 1
+#define KOCH_TARGET_AVX2
+#endif
+
+
+namespace {
+
+	// The same constants generateSnowflake uses, computed the same way
+	float const FIRST_ALPHA = 1.f / 3.f;
+	float const LAST_ALPHA = 2.f / 3.f;
+	float const FIRST_BETA = (float)(1 - FIRST_ALPHA);
+	float const LAST_BETA = (float)(1 - LAST_ALPHA);
+
+	float const ANGLE = 60.f * (float)(M_PI / 180.f);
+	float const COS_ANGLE = (float)cos(ANGLE);
+	float const SIN_ANGLE = (float)sin(ANGLE);
+
+	// Colour of the i-th segment on a level, by which child of its parent it is
+	glm::vec3 const CHILD_COLORS[4] = { BLUE, GREEN, RED, YELLOW };
+
+
+	// Note that the tip is rotatePoint(first, last, 60), which offsets both coordinates
+	// by the pivot's x. That is kept here so both generators draw the same curve.
+	void subdivideScalar(const float* srcX, const float* srcY, std::size_t begin, std::size_t end, float* dstX, float* dstY) {
+		for (std::size_t i = begin; i < end; i++) {
+			float px = srcX[i], py = srcY[i];
+			float qx = srcX[i + 1], qy = srcY[i + 1];
+
+			float fx = FIRST_BETA * px + FIRST_ALPHA * qx;
+			float fy = FIRST_BETA * py + FIRST_ALPHA * qy;
+			float lx = LAST_BETA * px + LAST_ALPHA * qx;
+			float ly = LAST_BETA * py + LAST_ALPHA * qy;
+
+			float dx = fx - lx;
+			float dy = fy - ly;
+			float mx = lx + dx * COS_ANGLE - dy * SIN_ANGLE;
+			float my = lx + dx * SIN_ANGLE + dy * COS_ANGLE;
+
+			dstX[4 * i + 0] = px; dstY[4 * i + 0] = py;
+			dstX[4 * i + 1] = fx; dstY[4 * i + 1] = fy;
+			dstX[4 * i + 2] = mx; dstY[4 * i + 2] = my;
+			dstX[4 * i + 3] = lx; dstY[4 * i + 3] = ly;
+		}
+	}
+
+
+#ifdef KOCH_SSE2
+	// 4 segments per iteration. p, first, tip and last are computed as 4-wide
+	// columns and transposed so each segment's 4 points land next to each other.
+	std::size_t subdivideSSE2(const float* srcX, const float* srcY, std::size_t segments, float* dstX, float* dstY) {
+		const __m128 firstAlpha = _mm_set1_ps(FIRST_ALPHA), firstBeta = _mm_set1_ps(FIRST_BETA);
+		const __m128 lastAlpha = _mm_set1_ps(LAST_ALPHA), lastBeta = _mm_set1_ps(LAST_BETA);
+		const __m128 cosAngle = _mm_set1_ps(COS_ANGLE), sinAngle = _mm_set1_ps(SIN_ANGLE);
+
+		std::size_t i = 0;
+		for (; i + 4 <= segments; i += 4) {
+			__m128 px = _mm_loadu_ps(srcX + i), py = _mm_loadu_ps(srcY + i);
+			__m128 qx = _mm_loadu_ps(srcX + i + 1), qy = _mm_loadu_ps(srcY + i + 1);
+
+			__m128 fx = _mm_add_ps(_mm_mul_ps(firstBeta, px), _mm_mul_ps(firstAlpha, qx));
+			__m128 fy = _mm_add_ps(_mm_mul_ps(firstBeta, py), _mm_mul_ps(firstAlpha, qy));
+			__m128 lx = _mm_add_ps(_mm_mul_ps(lastBeta, px), _mm_mul_ps(lastAlpha, qx));
+			__m128 ly = _mm_add_ps(_mm_mul_ps(lastBeta, py), _mm_mul_ps(lastAlpha, qy));
+
+			__m128 dx = _mm_sub_ps(fx, lx);
+			__m128 dy = _mm_sub_ps(fy, ly);
+			__m128 mx = _mm_sub_ps(_mm_add_ps(lx, _mm_mul_ps(dx, cosAngle)), _mm_mul_ps(dy, sinAngle));
+			__m128 my = _mm_add_ps(_mm_add_ps(lx, _mm_mul_ps(dx, sinAngle)), _mm_mul_ps(dy, cosAngle));
+
+			_MM_TRANSPOSE4_PS(px, fx, mx, lx);
+			_mm_storeu_ps(dstX + 4 * i + 0, px);
+			_mm_storeu_ps(dstX + 4 * i + 4, fx);
+			_mm_storeu_ps(dstX + 4 * i + 8, mx);
+			_mm_storeu_ps(dstX + 4 * i + 12, lx);
+
+			_MM_TRANSPOSE4_PS(py, fy, my, ly);
+			_mm_storeu_ps(dstY + 4 * i + 0, py);
+			_mm_storeu_ps(dstY + 4 * i + 4, fy);
+			_mm_storeu_ps(dstY + 4 * i + 8, my);
+			_mm_storeu_ps(dstY + 4 * i + 12, ly);
+		}
+		return i;
+	}
+#endif
+
+
+#ifdef KOCH_AVX2
+	// 8 wide version of the SSE2 transpose: four 4x4 transposes, one per 128 bit
+	// half, then the halves are swapped into segment order.
+	KOCH_TARGET_AVX2
+	void storeSegments8(float* dst, __m256 p, __m256 f, __m256 m, __m256 l) {
+		__m256 t0 = _mm256_unpacklo_ps(p, f);
+		__m256 t1 = _mm256_unpackhi_ps(p, f);
+		__m256 t2 = _mm256_unpacklo_ps(m, l);
+		__m256 t3 = _mm256_unpackhi_ps(m, l);
+
+		__m256 r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)); // segments 0 | 4
+		__m256 r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)); // segments 1 | 5
+		__m256 r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)); // segments 2 | 6
+		__m256 r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)); // segments 3 | 7
+
+		_mm256_storeu_ps(dst + 0, _mm256_permute2f128_ps(r0, r1, 0x20));
+		_mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(r2, r3, 0x20));
+		_mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(r0, r1, 0x31));
+		_mm256_storeu_ps(dst + 24, _mm256_permute2f128_ps(r2, r3, 0x31));
+	}
+
+	KOCH_TARGET_AVX2
+	std::size_t subdivideAVX2(const float* srcX, const float* srcY, std::size_t segments, float* dstX, float* dstY) {
+		const __m256 firstAlpha = _mm256_set1_ps(FIRST_ALPHA), firstBeta = _mm256_set1_ps(FIRST_BETA);
+		const __m256 lastAlpha = _mm256_set1_ps(LAST_ALPHA), lastBeta = _mm256_set1_ps(LAST_BETA);
+		const __m256 cosAngle = _mm256_set1_ps(COS_ANGLE), sinAngle = _mm256_set1_ps(SIN_ANGLE);
+
+		std::size_t i = 0;
+		for (; i + 8 <= segments; i += 8) {
+			__m256 px = _mm256_loadu_ps(srcX + i), py = _mm256_loadu_ps(srcY + i);
+			__m256 qx = _mm256_loadu_ps(srcX + i + 1), qy = _mm256_loadu_ps(srcY + i + 1);
+
+			__m256 fx = _mm256_add_ps(_mm256_mul_ps(firstBeta, px), _mm256_mul_ps(firstAlpha, qx));
+			__m256 fy = _mm256_add_ps(_mm256_mul_ps(firstBeta, py), _mm256_mul_ps(firstAlpha, qy));
+			__m256 lx = _mm256_add_ps(_mm256_mul_ps(lastBeta, px), _mm256_mul_ps(lastAlpha, qx));
+			__m256 ly = _mm256_add_ps(_mm256_mul_ps(lastBeta, py), _mm256_mul_ps(lastAlpha, qy));
+
+			__m256 dx = _mm256_sub_ps(fx, lx);
+			__m256 dy = _mm256_sub_ps(fy, ly);
+			__m256 mx = _mm256_sub_ps(_mm256_add_ps(lx, _mm256_mul_ps(dx, cosAngle)), _mm256_mul_ps(dy, sinAngle));
+			__m256 my = _mm256_add_ps(_mm256_add_ps(lx, _mm256_mul_ps(dx, sinAngle)), _mm256_mul_ps(dy, cosAngle));
+
+			storeSegments8(dstX + 4 * i, px, fx, mx, lx);
+			storeSegments8(dstY + 4 * i, py, fy, my, ly);
+		}
+		return i;
+	}
+
+	bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7) return false;
+
+		// AVX2 needs both the instructions and the OS saving the YMM registers
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+#endif
+}
+
+
+KochPath supportedKochPath(KochPath requested) {
+#ifdef KOCH_AVX2
+	static const bool avx2 = cpuHasAVX2();
+#else
+	const bool avx2 = false;
+#endif
+#ifdef KOCH_SSE2
+	const bool sse2 = true;
+#else
+	const bool sse2 = false;
+#endif
+
+	if ((requested == KochPath::Auto || requested == KochPath::AVX2) && avx2) return KochPath::AVX2;
+	if (requested != KochPath::Scalar && sse2) return KochPath::SSE2;
+	return KochPath::Scalar;
+}
+
+
+const char* kochPathName(KochPath path) {
+	switch (path) {
+	case KochPath::Auto: return "auto";
+	case KochPath::Scalar: return "scalar";
+	case KochPath::SSE2: return "sse2";
+	case KochPath::AVX2: return "avx2";
+	}
+	return "unknown";
+}
+
+
+void kochSubdivide(const float* srcX, const float* srcY, std::size_t segments, float* dstX, float* dstY, KochPath path) {
+	std::size_t done = 0;
+
+	switch (supportedKochPath(path)) {
+#ifdef KOCH_AVX2
+	case KochPath::AVX2:
+		done = subdivideAVX2(srcX, srcY, segments, dstX, dstY);
+		break;
+#endif
+#ifdef KOCH_SSE2
+	case KochPath::SSE2:
+		done = subdivideSSE2(srcX, srcY, segments, dstX, dstY);
+		break;
+#endif
+	default:
+		break;
+	}
+
+	// Whatever didn't fill a whole vector
+	subdivideScalar(srcX, srcY, done, segments, dstX, dstY);
+	dstX[4 * segments] = srcX[segments];
+	dstY[4 * segments] = srcY[segments];
+}
+
+
+void generateSnowflakeBreadthFirst(CPU_Geometry& snowflake, glm::vec2 start, glm::vec2 end, int iterations, KochBuffers& buffers) {
+	std::size_t segments = 1;
+	for (int i = 0; i < iterations; i++) segments *= 4;
+
+	for (int i = 0; i < 2; i++) {
+		buffers.x[i].resize(segments + 1);
+		buffers.y[i].resize(segments + 1);
+	}
+
+	int current = 0;
+	buffers.x[current][0] = start.x; buffers.y[current][0] = start.y;
+	buffers.x[current][1] = end.x; buffers.y[current][1] = end.y;
+
+	for (std::size_t levelSegments = 1; levelSegments < segments; levelSegments *= 4) {
+		kochSubdivide(
+			buffers.x[current].data(), buffers.y[current].data(), levelSegments,
+			buffers.x[1 - current].data(), buffers.y[1 - current].data(),
+			buffers.path
+		);
+		current = 1 - current;
+	}
+
+	snowflakeSegments(buffers.x[current].data(), buffers.y[current].data(), segments, iterations, snowflake);
+}
+
+
+void snowflakeSegments(const float* x, const float* y, std::size_t segments, int iterations, CPU_Geometry& snowflake) {
+	// generateSnowflake draws every segment on its own, as a start and end vertex.
+	// Everything gets overwritten, so clear first to not copy the old contents on growth.
+	snowflake.verts.clear();
+	snowflake.cols.clear();
+	snowflake.verts.resize(2 * segments);
+	snowflake.cols.resize(2 * segments);
+	for (std::size_t i = 0; i < segments; i++) {
+		snowflake.verts[2 * i + 0] = glm::vec3(x[i], y[i], 0.f);
+		snowflake.verts[2 * i + 1] = glm::vec3(x[i + 1], y[i + 1], 0.f);
+
+		glm::vec3 color = (iterations > 0) ? CHILD_COLORS[i % 4] : BLUE;
+		snowflake.cols[2 * i + 0] = color;
+		snowflake.cols[2 * i + 1] = color;
+	}
+}
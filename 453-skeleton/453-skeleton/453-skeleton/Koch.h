@@ -0,0 +1,54 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Breadth-first Koch curve generation.
+//
+// Instead of recursing per segment like generateSnowflake, a side of the
+// snowflake is kept as a polyline in structure-of-arrays form (all x, then all
+// y) and refined one whole level at a time. A level of n segments (n + 1
+// points) becomes 4n segments (4n + 1 points), so the kernel can work on 4 or 8
+// segments per instruction with SSE2 or AVX2 and falls back to plain C++
+// everywhere else.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+
+enum class KochPath {
+	Auto,   // best one this CPU supports
+	Scalar,
+	SSE2,
+	AVX2
+};
+
+// Resolves KochPath::Auto and anything the CPU can't run to a path that can be used here
+KochPath supportedKochPath(KochPath requested = KochPath::Auto);
+const char* kochPathName(KochPath path);
+
+
+// Ping-pong polyline buffers, kept around between calls so regenerating at the
+// same or a lower level doesn't allocate
+struct KochBuffers {
+	std::vector<float> x[2];
+	std::vector<float> y[2];
+	KochPath path = KochPath::Auto;
+};
+
+
+// One Koch step. Reads segments + 1 points from src and writes 4 * segments + 1 points
+// to dst, each segment pq replaced by p, first third, tip, second third.
+void kochSubdivide(const float* srcX, const float* srcY, std::size_t segments, float* dstX, float* dstY, KochPath path);
+
+// Breadth-first replacement for generateSnowflake. Overwrites snowflake with the
+// same vertices (within float tolerance) and the same colours as the recursive
+// version called with BLUE.
+void generateSnowflakeBreadthFirst(CPU_Geometry& snowflake, glm::vec2 start, glm::vec2 end, int iterations, KochBuffers& buffers);
+
+// Overwrites snowflake with the vertices and colours generateSnowflake produces for a
+// polyline of segments + 1 points that is the given number of iterations deep
+void snowflakeSegments(const float* x, const float* y, std::size_t segments, int iterations, CPU_Geometry& snowflake);
@@ -0,0 +1,266 @@
+#define _USE_MATH_DEFINES
+#include "LodFractals.h"
+
+#include "Fractals.h"
+#include "Koch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <math.h>
+
+
+ScreenSpace ScreenSpace::forViewport(glm::ivec2 size, glm::dvec2 center, double zoom) {
+	return { center, zoom, glm::dvec2(size) };
+}
+
+
+double ScreenSpace::pixels(glm::dvec2 p, glm::dvec2 q) const {
+	return glm::length((q - p) * zoom * 0.5 * size);
+}
+
+
+bool ScreenSpace::visible(glm::dvec2 lo, glm::dvec2 hi, double margin) const {
+	glm::dvec2 a = toPixels(lo) - margin;
+	glm::dvec2 b = toPixels(hi) + margin;
+	return a.x < size.x && a.y < size.y && b.x > 0.0 && b.y > 0.0;
+}
+
+
+namespace {
+	// Positions are Real, float for LodOutput::World and double for CameraRelative
+	template <typename Real>
+	using Point = glm::vec<2, Real>;
+
+	// Same rounding as midPoint, see Fractals.cpp
+	template <typename Real>
+	Point<Real> half(Point<Real> p, Point<Real> q) {
+		return p * Real(0.5) + q * Real(0.5);
+	}
+
+	template <typename Real>
+	struct TriangleFrame {
+		Point<Real> a, b, c;
+		int iterations;
+		int level;          // levels below the whole triangle
+		std::uint64_t index; // within its level, for serpinskyColor. Wraps past level 40.
+	};
+
+	template <typename Real>
+	struct SegmentFrame {
+		Point<Real> p, q;
+		int iterations;
+		glm::vec3 color; // by which child of its parent it is, like generateSnowflake
+		double pixels;   // a third of its parent's
+	};
+
+	glm::vec3 const CHILD_COLORS[4] = { BLUE, GREEN, RED, YELLOW };
+
+	// Primitives a primitive becomes after the given number of levels
+	double descendants(double children, int iterations) {
+		return std::pow(children, iterations);
+	}
+
+	template <typename Real>
+	glm::vec3 vertex(Point<Real> p, const ScreenSpace& screen, LodOutput output) {
+		if (output == LodOutput::World) return glm::vec3(glm::vec2(p), 0.f);
+		return glm::vec3(glm::vec2(screen.toClip(glm::dvec2(p))), 0.f);
+	}
+
+	// The 5 points a Koch step turns pq into, see kochSubdivide. Floats go through
+	// kochSubdivide itself so they come out the same as everywhere else.
+	void kochChildren(Point<float> p, Point<float> q, Point<float>* children) {
+		float x[2] = { p.x, q.x };
+		float y[2] = { p.y, q.y };
+		float childX[5], childY[5];
+		kochSubdivide(x, y, 1, childX, childY, KochPath::Scalar);
+		for (int i = 0; i < 5; i++) children[i] = Point<float>(childX[i], childY[i]);
+	}
+
+	// The same in double, tip bug and all
+	void kochChildren(Point<double> p, Point<double> q, Point<double>* children) {
+		double const FIRST_ALPHA = 1.0 / 3.0;
+		double const LAST_ALPHA = 2.0 / 3.0;
+		double const ANGLE = 60.0 * (M_PI / 180.0);
+
+		Point<double> first = (1.0 - FIRST_ALPHA) * p + FIRST_ALPHA * q;
+		Point<double> last = (1.0 - LAST_ALPHA) * p + LAST_ALPHA * q;
+		Point<double> d = first - last;
+		Point<double> tip(
+			last.x + d.x * cos(ANGLE) - d.y * sin(ANGLE),
+			last.x + d.x * sin(ANGLE) + d.y * cos(ANGLE)
+		);
+
+		children[0] = p;
+		children[1] = first;
+		children[2] = tip;
+		children[3] = last;
+		children[4] = q;
+	}
+
+
+	template <typename Real>
+	void serpinskyLod(Point<Real> a, Point<Real> b, Point<Real> c, int iterations, const ScreenSpace& screen, float minPixels,
+		LodOutput output, CPU_Geometry& triangle, LodStats& stats)
+	{
+		// Visited in the same order as fillSerpinsky, see there for the stack size
+		TriangleFrame<Real> stack[2 * MAX_LOD_ITERATIONS + 1];
+		int top = 0;
+		stack[top++] = { a, b, c, std::clamp(iterations, 0, MAX_LOD_ITERATIONS), 0, 0 };
+
+		while (top > 0) {
+			TriangleFrame<Real> frame = stack[--top];
+			glm::dvec2 da(frame.a), db(frame.b), dc(frame.c);
+
+			// Every child is inside its parent
+			if (!screen.visible(glm::min(glm::min(da, db), dc), glm::max(glm::max(da, db), dc))) {
+				stats.culled += descendants(3, frame.iterations);
+				continue;
+			}
+
+			// Splitting stops making anything smaller once the midpoints can't be told
+			// apart from the corners in Real, so that counts as being small enough too
+			Point<Real> d = half(frame.a, frame.b);
+			Point<Real> e = half(frame.a, frame.c);
+			Point<Real> f = half(frame.b, frame.c);
+			bool exhausted = (d == frame.a || d == frame.b || e == frame.a || e == frame.c || f == frame.b || f == frame.c);
+
+			double size = std::max({ screen.pixels(da, db), screen.pixels(da, dc), screen.pixels(db, dc) });
+			if (frame.iterations == 0 || size < minPixels || exhausted) {
+				triangle.verts.push_back(vertex(frame.a, screen, output));
+				triangle.verts.push_back(vertex(frame.b, screen, output));
+				triangle.verts.push_back(vertex(frame.c, screen, output));
+				// Coloured like the same triangle of its own level when that is generated in full
+				for (int corner = 0; corner < 3; corner++) {
+					triangle.cols.push_back(serpinskyColor(frame.level, 3 * frame.index + corner));
+				}
+				stats.drawn++;
+				stats.pruned += descendants(3, frame.iterations) - 1;
+				continue;
+			}
+
+			int level = frame.level + 1;
+			std::uint64_t index = 3 * frame.index;
+			stack[top++] = { e, f, frame.c, frame.iterations - 1, level, index + 2 };
+			stack[top++] = { d, frame.b, f, frame.iterations - 1, level, index + 1 };
+			stack[top++] = { frame.a, d, e, frame.iterations - 1, level, index };
+		}
+	}
+
+
+	template <typename Real>
+	void snowflakeLod(Point<Real> a, Point<Real> b, Point<Real> c, int iterations, const ScreenSpace& screen, float minPixels,
+		LodOutput output, CPU_Geometry& snowflake, LodStats& stats)
+	{
+		// Each pop pushes at most 4 frames one level deeper
+		SegmentFrame<Real> stack[3 * MAX_LOD_ITERATIONS + 1];
+		Point<Real> corners[3] = { a, b, c };
+		for (int side = 0; side < 3; side++) {
+			Point<Real> p = corners[side];
+			Point<Real> q = corners[(side + 1) % 3];
+			int top = 0;
+			stack[top++] = { p, q, iterations, BLUE, screen.pixels(glm::dvec2(p), glm::dvec2(q)) };
+
+			while (top > 0) {
+				SegmentFrame<Real> frame = stack[--top];
+				glm::dvec2 dp(frame.p), dq(frame.q);
+
+				// A correct Koch curve stays within a third of its length of the segment,
+				// so half is plenty. Strays from the tip bug can go further and may get culled.
+				if (!screen.visible(glm::min(dp, dq), glm::max(dp, dq), 0.5 * frame.pixels)) {
+					stats.culled += descendants(4, frame.iterations);
+					continue;
+				}
+
+				// The tip comes out in the wrong place (see the known bugs in README.txt),
+				// so the segments next to it don't actually shrink by a third. Measuring
+				// them would refine those all the way down.
+				Point<Real> children[5];
+				kochChildren(frame.p, frame.q, children);
+
+				// Same as for the Serpinsky triangle, past what Real can resolve
+				bool exhausted = (children[1] == frame.p || children[3] == frame.q || children[1] == children[3]);
+
+				if (frame.iterations == 0 || frame.pixels < minPixels || exhausted) {
+					snowflake.verts.push_back(vertex(frame.p, screen, output));
+					snowflake.verts.push_back(vertex(frame.q, screen, output));
+					snowflake.cols.push_back(frame.color);
+					snowflake.cols.push_back(frame.color);
+					stats.drawn++;
+					stats.pruned += descendants(4, frame.iterations) - 1;
+					continue;
+				}
+
+				// Pushed in reverse so they are popped in the order generateSnowflake visits them
+				for (int child = 4; child-- > 0;) {
+					stack[top++] = { children[child], children[child + 1], frame.iterations - 1, CHILD_COLORS[child], frame.pixels / 3.0 };
+				}
+			}
+		}
+	}
+}
+
+
+void generateSerpinskyLod(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c, int iterations, const ScreenSpace& screen, float minPixels,
+	LodOutput output, CPU_Geometry& triangle, LodStats& stats)
+{
+	stats = LodStats();
+	triangle.verts.clear();
+	triangle.cols.clear();
+
+	if (output == LodOutput::World) serpinskyLod<float>(a, b, c, iterations, screen, minPixels, output, triangle, stats);
+	else serpinskyLod<double>(a, b, c, iterations, screen, minPixels, output, triangle, stats);
+}
+
+
+void generateSnowflakeLod(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c, int iterations, const ScreenSpace& screen, float minPixels,
+	LodOutput output, CPU_Geometry& snowflake, LodStats& stats)
+{
+	stats = LodStats();
+	snowflake.verts.clear();
+	snowflake.cols.clear();
+	iterations = std::clamp(iterations, 0, MAX_LOD_ITERATIONS);
+
+	if (output == LodOutput::World) snowflakeLod<float>(a, b, c, iterations, screen, minPixels, output, snowflake, stats);
+	else snowflakeLod<double>(a, b, c, iterations, screen, minPixels, output, snowflake, stats);
+}
+
+
+void generateSquareDiamondLod(const std::vector<std::vector<float>>& initialPoints, int iterations, const ScreenSpace& screen,
+	float minPixels, LodOutput output, CPU_Geometry& squareDiamond, LodStats& stats)
+{
+	stats = LodStats();
+	squareDiamond.verts.clear();
+	squareDiamond.cols.clear();
+	iterations = std::clamp(iterations, 0, MAX_LOD_ITERATIONS);
+
+	for (int level = 0; level <= iterations; level++) {
+		// Every level is half the size of the one before, see SquareDiamondLevels::refine.
+		// That is exact in float and double alike, only where it lands needs double.
+		float factor = std::ldexp(1.f, -level);
+		glm::dvec2 p(squareDiamondPoint(initialPoints[0], factor));
+		glm::dvec2 q(squareDiamondPoint(initialPoints[1], factor));
+		if (level > 0 && screen.pixels(p, q) < minPixels) {
+			stats.pruned += 2.0 * (iterations - level + 1);
+			break;
+		}
+
+		// Every level is inside the one before, so once one is off screen so is the rest
+		glm::dvec2 lo(p), hi(p);
+		for (const std::vector<float>& point : initialPoints) {
+			glm::dvec2 corner(squareDiamondPoint(point, factor));
+			lo = glm::min(lo, corner);
+			hi = glm::max(hi, corner);
+		}
+		if (!screen.visible(lo, hi)) {
+			stats.culled += 2.0 * (iterations - level + 1);
+			break;
+		}
+
+		for (std::size_t i = 0; i < initialPoints.size(); i++) {
+			glm::vec2 corner(squareDiamondPoint(initialPoints[i], factor));
+			squareDiamond.verts.push_back(vertex(corner, screen, output));
+			squareDiamond.cols.push_back((i < 5) ? BLUE : RED);
+		}
+		stats.drawn += 2;
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Fractals that stop refining below a pixel.
+//
+// Past a certain level, the triangles and segments of a scene get smaller than
+// a pixel and every further level only multiplies what is generated, uploaded
+// and rasterized without changing the picture. These generators take where
+// the scene lands on screen and leave a primitive as it is once it is smaller
+// than a given number of pixels, so the output is bounded by the resolution
+// rather than by 3^n or 4^n.
+//
+// They also leave out every primitive whose subtree can't reach the viewport,
+// so zoomed in, only the part on screen is refined. Everything that would have
+// been drawn in place of a primitive that was left as it is gets counted as
+// pruned, everything that was left out as culled.
+//
+// Zoomed in far enough, neither the float positions of the other generators
+// nor the float camera in the shaders can tell the primitives on screen apart.
+// LodOutput::CameraRelative recurses in double instead and only converts to
+// float once a vertex has been moved into clip space by the camera, where the
+// numbers on screen are small again.
+//------------------------------------------------------------------------------
+
+#include "Geometry.h"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+
+// Deepest level the LOD generators take. Only the levels above the pixel
+// threshold cost anything, this bounds their fixed size stacks. Double
+// positions stop telling the Serpinsky triangle's corners apart a little
+// past it.
+int const MAX_LOD_ITERATIONS = 50;
+
+
+// Where a point lands on screen, for a viewport size pixels big looking at
+// center with the given zoom like Camera2D. p ends up at pixel
+// ((p - center) * zoom + 1) * size / 2.
+struct ScreenSpace {
+	glm::dvec2 center;
+	double zoom;
+	glm::dvec2 size;
+
+	static ScreenSpace forViewport(glm::ivec2 size, glm::dvec2 center = glm::dvec2(0.0), double zoom = 1.0);
+
+	glm::dvec2 toClip(glm::dvec2 p) const { return (p - center) * zoom; }
+	glm::dvec2 toPixels(glm::dvec2 p) const { return (toClip(p) + 1.0) * 0.5 * size; }
+
+	// Length of the segment pq on screen
+	double pixels(glm::dvec2 p, glm::dvec2 q) const;
+
+	// Whether any of the box from lo to hi is on screen once grown by margin pixels
+	bool visible(glm::dvec2 lo, glm::dvec2 hi, double margin = 0.0) const;
+};
+
+
+// Where the vertices the generators write are
+enum class LodOutput {
+	World,         // in the scene, for the camera in the shaders. Generated in float.
+	CameraRelative // in clip space, the camera already applied. Generated in double.
+};
+
+
+// Counts in double, a deep enough level has more primitives than fit in 64 bits
+struct LodStats {
+	double drawn = 0.0;  // primitives generated
+	double pruned = 0.0; // primitives not generated because their parent was below the threshold
+	double culled = 0.0; // primitives not generated because they were off screen
+};
+
+
+// Overwrites triangle with the Serpinsky triangle abc, except that a triangle
+// whose longest edge is under minPixels long is not split any further
+void generateSerpinskyLod(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c, int iterations, const ScreenSpace& screen, float minPixels,
+	LodOutput output, CPU_Geometry& triangle, LodStats& stats);
+
+// Overwrites snowflake with the three sides ab, bc and ca of the Koch snowflake
+// as lines, except that a segment under minPixels long is not split any
+// further. A segment counts as a third as long as its parent, and its subtree
+// as staying within half that of it.
+void generateSnowflakeLod(glm::dvec2 a, glm::dvec2 b, glm::dvec2 c, int iterations, const ScreenSpace& screen, float minPixels,
+	LodOutput output, CPU_Geometry& snowflake, LodStats& stats);
+
+// Overwrites squareDiamond with the square diamond, without the levels where the
+// square's sides are under minPixels long. Every square and diamond is a primitive.
+void generateSquareDiamondLod(const std::vector<std::vector<float>>& initialPoints, int iterations, const ScreenSpace& screen,
+	float minPixels, LodOutput output, CPU_Geometry& squareDiamond, LodStats& stats);
@@ -0,0 +1,64 @@
+#include "OffscreenTarget.h"
+
+#include "Log.h"
+
+#include <fstream>
+#include <stdexcept>
+
+
+OffscreenTarget::OffscreenTarget(int width, int height)
+	: width(width)
+	, height(height)
+{
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_SRGB8_ALPHA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		Log::error("OFFSCREEN_TARGET framebuffer incomplete: {:#x}", status);
+		throw std::runtime_error("Failed to create offscreen framebuffer.");
+	}
+}
+
+
+void OffscreenTarget::bind() {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+
+std::vector<unsigned char> OffscreenTarget::readPixels() {
+	std::vector<unsigned char> pixels(std::size_t(3) * std::size_t(width) * std::size_t(height));
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+	return pixels;
+}
+
+
+bool OffscreenTarget::save(const std::string& path) {
+	std::vector<unsigned char> pixels = readPixels();
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		Log::error("OFFSCREEN_TARGET could not open {} for writing", path);
+		return false;
+	}
+
+	// PPM goes top to bottom
+	file << "P6\n" << width << " " << height << "\n255\n";
+	std::size_t row = std::size_t(3) * std::size_t(width);
+	for (int y = height; y-- > 0;) {
+		file.write(reinterpret_cast<const char*>(pixels.data() + row * std::size_t(y)), std::streamsize(row));
+	}
+	return bool(file);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A framebuffer object to render into instead of a window.
+//
+// Colour is sRGB like the default framebuffer, so GL_FRAMEBUFFER_SRGB behaves
+// the same either way, and there is a depth buffer for the same reason. Used
+// by --headless, where the window only exists to own the GL context.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+
+class OffscreenTarget {
+
+public:
+	OffscreenTarget(int width, int height);
+
+	// Binds it for drawing and reading, and covers it with the viewport
+	void bind();
+
+	int getWidth() const { return width; }
+	int getHeight() const { return height; }
+
+	// RGB rows bottom to top, as GL reads them
+	std::vector<unsigned char> readPixels();
+
+	// Writes the current contents as a binary PPM, false if the file can't be written
+	bool save(const std::string& path);
+
+private:
+	FramebufferHandle framebuffer;
+	RenderbufferHandle color;
+	RenderbufferHandle depth;
+	int width;
+	int height;
+};
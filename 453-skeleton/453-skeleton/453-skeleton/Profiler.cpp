@@ -0,0 +1,144 @@
+#include "Profiler.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace {
+	// Samples per scope that the statistics are taken over
+	std::size_t const WINDOW = 512;
+}
+
+
+Profiler::Profiler(bool enabled, const std::string& csvPath, int reportEvery)
+	: on(enabled || !csvPath.empty())
+	, reportEvery(std::max(reportEvery, 1))
+	, frameStart(Clock::now())
+{
+	if (csvPath.empty()) return;
+
+	csv.open(csvPath);
+	if (!csv) {
+		Log::error("PROFILER could not open {} for writing", csvPath);
+		return;
+	}
+	csv << "frame,scope,clock,ms\n";
+}
+
+
+void Profiler::beginFrame() {
+	if (on) frameStart = Clock::now();
+}
+
+
+void Profiler::endFrame() {
+	if (!on) return;
+
+	Clock::time_point now = Clock::now();
+	addCpuSample("frame", std::chrono::duration<double, std::milli>(now - frameStart).count());
+	frameStart = now;
+
+	collectGpu();
+
+	frame++;
+	if (frame % std::size_t(reportEvery) == 0) report();
+}
+
+
+void Profiler::addCpuSample(const char* name, double ms) {
+	// Called from outside the scopes too, disabled that mustn't create a series
+	if (!on) return;
+	addSample(seriesIndex(name, false), ms, frame);
+}
+
+
+bool Profiler::beginGpu(const char* name) {
+	if (!on) return false;
+	if (gpuActive) {
+		if (!warnedNested) Log::warn("PROFILER GPU scope {} nested in another one, skipped", name);
+		warnedNested = true;
+		return false;
+	}
+
+	if (freeQueries.empty()) {
+		freeQueries.push_back(queries.size());
+		queries.emplace_back();
+	}
+	std::size_t query = freeQueries.back();
+	freeQueries.pop_back();
+
+	pending.push_back({ query, seriesIndex(name, true), frame });
+	glBeginQuery(GL_TIME_ELAPSED, queries[query]);
+	gpuActive = true;
+	return true;
+}
+
+
+void Profiler::endGpu() {
+	if (!gpuActive) return;
+	glEndQuery(GL_TIME_ELAPSED);
+	gpuActive = false;
+}
+
+
+std::size_t Profiler::seriesIndex(const char* name, bool gpu) {
+	// Only a handful of scopes, a linear search is fine
+	for (std::size_t i = 0; i < series.size(); i++) {
+		if (series[i].gpu == gpu && std::strcmp(series[i].name, name) == 0) return i;
+	}
+	series.push_back({ name, gpu, {}, 0 });
+	series.back().samples.reserve(WINDOW);
+	return series.size() - 1;
+}
+
+
+void Profiler::addSample(std::size_t index, double ms, std::size_t sampleFrame) {
+	if (!on) return;
+	Series& s = series[index];
+	if (s.samples.size() < WINDOW) s.samples.push_back(ms);
+	else s.samples[s.next] = ms;
+	s.next = (s.next + 1) % WINDOW;
+
+	if (csv.is_open()) {
+		csv << sampleFrame << ',' << s.name << ',' << (s.gpu ? "gpu" : "cpu") << ',' << ms << '\n';
+	}
+}
+
+
+void Profiler::collectGpu() {
+	// Queries finish in the order they were issued, so stop at the first one that
+	// isn't done yet instead of waiting for it. The one still open can't be read either.
+	while (!pending.empty() && !(gpuActive && pending.size() == 1)) {
+		PendingQuery next = pending.front();
+
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(queries[next.query], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) break;
+
+		GLuint64 ns = 0;
+		glGetQueryObjectui64v(queries[next.query], GL_QUERY_RESULT, &ns);
+		addSample(next.series, double(ns) / 1e6, next.frame);
+
+		pending.pop_front();
+		freeQueries.push_back(next.query);
+	}
+}
+
+
+void Profiler::report() const {
+	std::vector<double> sorted;
+	for (const Series& s : series) {
+		if (s.samples.empty()) continue;
+
+		sorted = s.samples;
+		std::sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double ms : sorted) sum += ms;
+		std::size_t p99 = std::min(sorted.size() - 1, sorted.size() * 99 / 100);
+
+		Log::info("PROFILE {:>10} {}: min {:.3f} avg {:.3f} p99 {:.3f} ms over {} samples",
+			s.name, s.gpu ? "gpu" : "cpu", sorted.front(), sum / double(sorted.size()), sorted[p99], sorted.size());
+	}
+}
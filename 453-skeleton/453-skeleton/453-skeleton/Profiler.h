@@ -0,0 +1,143 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Per-frame CPU and GPU timing.
+//
+// ProfileScope times a block on the CPU, GpuProfileScope times the GL commands
+// issued in a block with a GL_TIME_ELAPSED query. Query results are only read
+// once the GPU says they are available, a frame or two later, so timing never
+// stalls the pipeline. Every reportEvery frames the min/avg/p99 of the last
+// samples of each named scope are logged, and every sample can go to a CSV file.
+//
+// A disabled profiler costs one branch per scope.
+//
+// Example:
+//		Profiler profiler(true);
+//		while (...) {
+//			{ ProfileScope scope(profiler, "generate"); ... }
+//			{ GpuProfileScope scope(profiler, "draw"); glDrawArrays(...); }
+//			profiler.endFrame();
+//		}
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+class Profiler {
+
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// csvPath empty means no CSV
+	Profiler(bool enabled = false, const std::string& csvPath = "", int reportEvery = 120);
+
+	// Owns GL queries and a file, so no copying or moving
+	Profiler(const Profiler&) = delete;
+	Profiler operator=(const Profiler&) = delete;
+
+	// Public interface
+	bool enabled() const { return on; }
+
+	// Starts the "frame" scope over. Only needed by loops that sleep between
+	// frames, otherwise every frame starts where the last one ended.
+	void beginFrame();
+
+	// Records the time since the last call as the "frame" scope, collects the
+	// GPU results that have arrived and logs a report when one is due
+	void endFrame();
+
+	// Used by the scopes. Names are compared by content but have to outlive the profiler.
+	void addCpuSample(const char* name, double ms);
+	bool beginGpu(const char* name); // false if it couldn't, endGpu must not be called then
+	void endGpu();
+
+private:
+	struct Series {
+		const char* name;
+		bool gpu;
+		std::vector<double> samples; // ring of the last WINDOW samples
+		std::size_t next = 0;
+	};
+
+	struct PendingQuery {
+		std::size_t query;  // index into queries
+		std::size_t series;
+		std::size_t frame;
+	};
+
+	bool on;
+	int reportEvery;
+	std::size_t frame = 0;
+	Clock::time_point frameStart;
+
+	std::vector<Series> series;
+
+	std::vector<QueryHandle> queries;
+	std::vector<std::size_t> freeQueries;
+	std::deque<PendingQuery> pending;
+	bool gpuActive = false;
+	bool warnedNested = false;
+
+	std::ofstream csv;
+
+	std::size_t seriesIndex(const char* name, bool gpu);
+	void addSample(std::size_t index, double ms, std::size_t sampleFrame);
+	void collectGpu();
+	void report() const;
+};
+
+
+// Times its own lifetime on the CPU
+class ProfileScope {
+
+public:
+	ProfileScope(Profiler& profiler, const char* name)
+		: profiler(profiler.enabled() ? &profiler : nullptr)
+		, name(name)
+	{
+		if (this->profiler != nullptr) start = Profiler::Clock::now();
+	}
+
+	~ProfileScope() {
+		if (profiler == nullptr) return;
+		profiler->addCpuSample(name, std::chrono::duration<double, std::milli>(Profiler::Clock::now() - start).count());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope operator=(const ProfileScope&) = delete;
+
+private:
+	Profiler* profiler;
+	const char* name;
+	Profiler::Clock::time_point start;
+};
+
+
+// Times the GL commands issued during its lifetime on the GPU. GL_TIME_ELAPSED
+// queries can't nest, so neither can these.
+class GpuProfileScope {
+
+public:
+	GpuProfileScope(Profiler& profiler, const char* name)
+		: profiler((profiler.enabled() && profiler.beginGpu(name)) ? &profiler : nullptr)
+	{}
+
+	~GpuProfileScope() {
+		if (profiler != nullptr) profiler->endGpu();
+	}
+
+	GpuProfileScope(const GpuProfileScope&) = delete;
+	GpuProfileScope operator=(const GpuProfileScope&) = delete;
+
+private:
+	Profiler* profiler;
+};
@@ -10,6 +10,40 @@
 #include <vector>
 
 
+namespace {
+	// Reads path into source, replacing every line that is #include "name" with the
+	// contents of name, looked up next to path. GLSL has no includes of its own,
+	// this lets shaders share functions without pasting them.
+	bool readSource(const std::string& path, std::string& source, int depth = 0) {
+		std::ifstream file(path);
+		if (!file) {
+			Log::error("SHADER reading {}:\n{}", path, strerror(errno));
+			return false;
+		}
+
+		std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+		std::string line;
+		while (std::getline(file, line)) {
+			std::size_t open = line.find_first_not_of(" \t");
+			if (open == std::string::npos || line.compare(open, 10, "#include \"") != 0) {
+				source += line;
+				source += '\n';
+				continue;
+			}
+
+			std::size_t first = open + 10;
+			std::size_t close = line.find('"', first);
+			if (close == std::string::npos || depth >= 8) {
+				Log::error("SHADER bad #include in {}:\n{}", path, line);
+				return false;
+			}
+			if (!readSource(directory + line.substr(first, close - first), source, depth + 1)) return false;
+		}
+		return true;
+	}
+}
+
+
 Shader::Shader(const std::string& path, GLenum type)
 	: shaderID(type)
 	, type(type)
@@ -24,28 +58,7 @@ bool Shader::compile() {
 
 	// read shader source
 	std::string sourceString;
-	std::ifstream file;
-
-	// ensure ifstream objects can throw exceptions:
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-	try {
-		// open file
-		file.open(path);
-		std::stringstream sourceStream;
-
-		// read file buffer contents into stream
-		sourceStream << file.rdbuf();
-
-		// close file handler
-		file.close();
-
-		// convert stream into string
-		sourceString = sourceStream.str();
-	}
-	catch (std::ifstream::failure &e) {
-		Log::error("SHADER reading {}:\n{}", path, strerror(errno));
-		return false;
-	}
+	if (!readSource(path, sourceString)) return false;
 	const GLchar* sourceCode = sourceString.c_str();
 
 
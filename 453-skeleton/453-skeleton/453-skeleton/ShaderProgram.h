@@ -24,6 +24,7 @@ public:
 	// Public interface
 	bool recompile();
 	void use() const { glUseProgram(programID); }
+	GLint uniformLocation(const char* name) const { return glGetUniformLocation(programID, name); }
 
 	void friend attach(ShaderProgram& sp, Shader& s);
 
@@ -0,0 +1,163 @@
+#include "StreamBuffer.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <utility>
+
+
+namespace {
+	// Keeps every range aligned for any attribute type
+	GLsizeiptr const ALIGNMENT = 16;
+
+	GLbitfield const PERSISTENT_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+}
+
+
+StreamBuffer::Stats StreamBuffer::counters;
+
+
+bool StreamBuffer::persistentSupported() {
+	return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+}
+
+
+StreamBuffer::StreamBuffer(GLsizeiptr capacity, bool persistent)
+	: bufferID{}
+	, capacity(0)
+	, persistent(persistent && persistentSupported())
+{
+	allocate(capacity);
+}
+
+
+StreamBuffer::~StreamBuffer() {
+	release();
+}
+
+
+void* StreamBuffer::map(GLsizeiptr size, GLintptr& offset) {
+	// Empty uploads still get a range, mapping zero bytes is an error
+	size = std::max((size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, ALIGNMENT);
+
+	// Anything written before the last draw can only be reused once that draw is done
+	if (persistent && drawnSinceMap) fenceWritten();
+	drawnSinceMap = false;
+
+	// At most a quarter of the ring per upload, so the ranges of one draw don't
+	// have to wait for each other
+	if (4 * size > capacity) {
+		allocate(std::max(2 * capacity, 4 * size));
+		counters.grows++;
+	}
+
+	if (head + size > capacity) {
+		head = 0;
+		counters.wraps++;
+
+		if (!persistent) {
+			// Orphan, the GPU keeps reading the old storage while we fill the new one
+			bind();
+			glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+		}
+	}
+
+	offset = head;
+	head += size;
+
+	counters.uploads++;
+	counters.bytes += std::size_t(size);
+
+	if (persistent) {
+		waitFor(offset, offset + size);
+		inFlight.push_back({ offset, offset + size, 0 });
+		return mapped + offset;
+	}
+
+	// Only ranges past head are written until the next orphan, so this can't touch anything in use
+	bind();
+	return glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+}
+
+
+void StreamBuffer::unmap() {
+	// Coherent mappings need nothing
+	if (persistent) return;
+
+	bind();
+	glUnmapBuffer(GL_ARRAY_BUFFER);
+}
+
+
+void StreamBuffer::allocate(GLsizeiptr newCapacity) {
+	// The old buffer stays alive for as long as a vertex array still points at it
+	release();
+	bufferID = VertexBufferHandle();
+	capacity = newCapacity;
+	head = 0;
+
+	bind();
+	if (persistent) {
+		glBufferStorage(GL_ARRAY_BUFFER, capacity, nullptr, PERSISTENT_FLAGS);
+		mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, capacity, PERSISTENT_FLAGS));
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	}
+}
+
+
+void StreamBuffer::fenceWritten() {
+	GLsync fence = 0;
+	for (Range& range : inFlight) {
+		if (range.fence != 0) continue;
+		if (fence == 0) fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		range.fence = fence;
+	}
+}
+
+
+void StreamBuffer::waitFor(GLintptr begin, GLintptr end) {
+	// Ranges are in the order they were written, and the GPU finishes them in that
+	// order too, so retiring from the front until nothing overlaps is enough
+	auto overlaps = [&](const Range& range) { return range.begin < end && begin < range.end; };
+
+	while (std::any_of(inFlight.begin(), inFlight.end(), overlaps)) {
+		Range range = inFlight.front();
+		inFlight.pop_front();
+
+		// Written but never drawn, nothing to wait for
+		if (range.fence == 0) continue;
+
+		// The range can't be written again until the GPU is done with it, however
+		// long that takes, so a second from now isn't a reason to give up either
+		GLenum status = glClientWaitSync(range.fence, 0, 0);
+		if (status == GL_TIMEOUT_EXPIRED) counters.stalls++;
+		while (status == GL_TIMEOUT_EXPIRED) {
+			status = glClientWaitSync(range.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+		}
+		if (status == GL_WAIT_FAILED) {
+			// Nothing says what the GPU is still reading then, so wait for all of it
+			Log::error("StreamBuffer: waiting for a fence failed, finishing every GPU command instead");
+			glFinish();
+		}
+
+		// Ranges fenced together share the fence, the last one deletes it
+		if (inFlight.empty() || inFlight.front().fence != range.fence) glDeleteSync(range.fence);
+	}
+}
+
+
+void StreamBuffer::release() {
+	if (mapped != nullptr) {
+		bind();
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		mapped = nullptr;
+	}
+	GLsync deleted = 0;
+	for (Range& range : inFlight) {
+		if (range.fence != 0 && range.fence != deleted) glDeleteSync(range.fence);
+		deleted = range.fence;
+	}
+	inFlight.clear();
+}
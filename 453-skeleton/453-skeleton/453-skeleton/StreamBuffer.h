@@ -0,0 +1,85 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A ring buffer for vertex data that is replaced often.
+//
+// glBufferData on a buffer the GPU may still be drawing from either stalls or
+// makes the driver copy behind our back. Instead, every upload here goes to the
+// next free range of one big buffer, and a range is only written again once
+// the GPU is known to be done with it.
+//
+// With ARB_buffer_storage (core in 4.4, common as an extension on 3.3) the
+// buffer is mapped once, persistently and coherently, and each range is
+// protected by a fence. On plain 3.3 the ranges are mapped with
+// GL_MAP_UNSYNCHRONIZED_BIT instead, and the buffer is orphaned every time
+// the ring wraps, so nothing ever has to wait there either.
+//------------------------------------------------------------------------------
+
+#include "GLHandles.h"
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <deque>
+
+
+class StreamBuffer {
+
+public:
+	// persistent = false forces the glMapBufferRange path even where buffer storage exists
+	StreamBuffer(GLsizeiptr capacity = 1 << 20, bool persistent = true);
+	~StreamBuffer();
+
+	// The fences and the mapping belong to this buffer, so no copying or moving
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer operator=(const StreamBuffer&) = delete;
+
+	// Public interface
+
+	// Space for size bytes that no draw is still reading from. Write the data to
+	// the returned pointer, then call unmap before drawing. offset is where the
+	// data starts in buffer(), which may be a different buffer after every call.
+	void* map(GLsizeiptr size, GLintptr& offset);
+	void unmap();
+
+	// Has to be called whenever something that reads from this buffer is drawn, so
+	// the ranges written before it get fenced by the next map
+	void used() { drawnSinceMap = true; }
+
+	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
+
+	// Counted over every StreamBuffer
+	struct Stats {
+		std::size_t uploads = 0;
+		std::size_t bytes = 0;
+		std::size_t wraps = 0;
+		std::size_t grows = 0;
+		std::size_t stalls = 0; // maps that had to wait for the GPU
+	};
+	static const Stats& totals() { return counters; }
+
+	static bool persistentSupported();
+
+private:
+	struct Range {
+		GLintptr begin;
+		GLintptr end;
+		GLsync fence; // 0 until something drawn after the write has been fenced
+	};
+
+	VertexBufferHandle bufferID;
+	GLsizeiptr capacity;
+	bool persistent;
+	char* mapped = nullptr; // the whole buffer when persistent
+
+	GLintptr head = 0;
+	std::deque<Range> inFlight;
+	bool drawnSinceMap = false;
+
+	static Stats counters;
+
+	void allocate(GLsizeiptr newCapacity);
+	void fenceWritten();
+	void waitFor(GLintptr begin, GLintptr end);
+	void release();
+};
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+namespace {
+	// Which pool (if any) the current thread works for, and its queue in that pool
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local std::size_t currentQueue = 0;
+}
+
+
+ThreadPool::ThreadPool(unsigned threadCount)
+	: queued(0)
+	, pending(0)
+	, nextQueue(0)
+	, stopping(false)
+{
+	threadCount = std::max(threadCount, 1u);
+
+	for (unsigned i = 0; i < threadCount; i++) {
+		queues.push_back(std::make_unique<Queue>());
+	}
+	for (unsigned i = 1; i < threadCount; i++) {
+		threads.emplace_back(&ThreadPool::workerLoop, this, std::size_t(i));
+	}
+}
+
+
+ThreadPool::~ThreadPool() {
+	wait();
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	wakeup.notify_all();
+	for (std::thread& thread : threads) thread.join();
+}
+
+
+void ThreadPool::submit(std::function<void()> task) {
+	std::size_t index = (currentPool == this)
+		? currentQueue
+		: nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+	pending++;
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		// Counted under the sleep mutex so a thread that is about to sleep can't miss it
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queued++;
+	}
+	wakeup.notify_one();
+}
+
+
+void ThreadPool::wait() {
+	const ThreadPool* previousPool = currentPool;
+	std::size_t previousQueue = currentQueue;
+	currentPool = this;
+	currentQueue = 0;
+
+	while (pending > 0) {
+		if (runOne(0)) continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeup.wait(lock, [this]() { return pending == 0 || queued > 0; });
+	}
+
+	currentPool = previousPool;
+	currentQueue = previousQueue;
+}
+
+
+void ThreadPool::workerLoop(std::size_t index) {
+	currentPool = this;
+	currentQueue = index;
+
+	while (true) {
+		if (runOne(index)) continue;
+
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		wakeup.wait(lock, [this]() { return stopping || queued > 0; });
+		if (stopping && queued == 0) return;
+	}
+}
+
+
+bool ThreadPool::runOne(std::size_t home) {
+	std::function<void()> task;
+	if (!pop(home, task) && !steal(home, task)) return false;
+
+	queued--;
+	task();
+
+	if (--pending == 0) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeup.notify_all();
+	}
+	return true;
+}
+
+
+bool ThreadPool::pop(std::size_t index, std::function<void()>& task) {
+	Queue& queue = *queues[index];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.tasks.empty()) return false;
+
+	task = std::move(queue.tasks.back());
+	queue.tasks.pop_back();
+	return true;
+}
+
+
+bool ThreadPool::steal(std::size_t thief, std::function<void()>& task) {
+	for (std::size_t i = 1; i < queues.size(); i++) {
+		Queue& victim = *queues[(thief + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.tasks.empty()) continue;
+
+		task = std::move(victim.tasks.front());
+		victim.tasks.pop_front();
+		return true;
+	}
+	return false;
+}
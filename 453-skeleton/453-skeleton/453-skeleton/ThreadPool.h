@@ -0,0 +1,69 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// A small work-stealing thread pool.
+//
+// Every participating thread owns a queue. Tasks submitted from inside a task go
+// to the submitting thread's own queue, everything else is spread round-robin.
+// A thread takes work from the back of its own queue first (newest, still hot in
+// cache) and only when that is empty steals from the front of someone else's.
+//
+// A pool of n threads spawns n - 1 workers. The thread that calls wait() is
+// the n-th and runs tasks too, so ThreadPool(1) executes everything inside wait().
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+class ThreadPool {
+
+public:
+	explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+
+	// Threads can be neither copied nor moved
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool operator=(const ThreadPool&) = delete;
+
+	// Finishes whatever is still queued, then joins the workers
+	~ThreadPool();
+
+	// Public interface
+	void submit(std::function<void()> task);
+
+	// Blocks until every submitted task (including ones submitted by tasks)
+	// has finished, running tasks on the calling thread in the meantime.
+	void wait();
+
+	unsigned size() const { return unsigned(queues.size()); }
+
+private:
+	struct Queue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	// queues[0] belongs to whoever calls wait(), queues[i] to threads[i - 1]
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::atomic<std::size_t> queued;  // tasks sitting in a queue
+	std::atomic<std::size_t> pending; // tasks queued or running
+	std::atomic<std::size_t> nextQueue;
+
+	std::mutex sleepMutex;
+	std::condition_variable wakeup;
+	bool stopping;
+
+	void workerLoop(std::size_t index);
+	bool runOne(std::size_t home);
+	bool pop(std::size_t index, std::function<void()>& task);
+	bool steal(std::size_t thief, std::function<void()>& task);
+};
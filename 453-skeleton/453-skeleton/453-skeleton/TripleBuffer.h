@@ -0,0 +1,59 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Lock-free handoff of the newest value from one writer thread to one reader.
+//
+// Three slots: the writer fills its back slot and swaps it with the middle one,
+// the reader swaps its front slot with the middle one when that holds something
+// new. Neither side ever waits for the other, the reader just skips values it
+// was too slow to see, and each slot keeps its allocations from one use to the
+// next.
+//
+// Example:
+//		// writer thread
+//		buffer.back() = makeValue();
+//		buffer.publish();
+//
+//		// reader thread
+//		if (buffer.update()) use(buffer.front());
+//------------------------------------------------------------------------------
+
+#include <atomic>
+
+
+template <typename T>
+class TripleBuffer {
+
+public:
+	TripleBuffer() = default;
+
+	// Shared between threads, so no copying or moving
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer operator=(const TripleBuffer&) = delete;
+
+	// Writer side. The back slot holds whatever the writer last left in it
+	// three publishes ago, reuse it rather than replacing it.
+	T& back() { return slots[backIndex]; }
+	void publish() {
+		backIndex = middle.exchange(backIndex | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// Reader side. False if nothing was published since the last update, front()
+	// stays the same then.
+	bool update() {
+		if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) return false;
+		frontIndex = middle.exchange(frontIndex, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	const T& front() const { return slots[frontIndex]; }
+
+private:
+	// The middle slot's index, plus whether the writer published it since the reader last looked
+	static constexpr unsigned INDEX = 3;
+	static constexpr unsigned FRESH = 4;
+
+	T slots[3];
+	std::atomic<unsigned> middle{ 1 };
+	unsigned backIndex = 0;  // writer only
+	unsigned frontIndex = 2; // reader only
+};
@@ -1,18 +1,60 @@
 #include "VertexBuffer.h"
 
+#include <algorithm>
 #include <utility>
 
 
-VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType)
+VertexBuffer::Stats VertexBuffer::counters;
+
+
+VertexBuffer::VertexBuffer(GLuint index, GLint size, GLenum dataType, GLboolean normalized, GLuint divisor)
 	: bufferID{}
 {
 	bind();
-	glVertexAttribPointer(index, size, dataType, GL_FALSE, 0, (void*)0);
+	glVertexAttribPointer(index, size, dataType, normalized, 0, (void*)0);
 	glEnableVertexAttribArray(index);
+	if (divisor != 0) {
+		glVertexAttribDivisor(index, divisor);
+	}
 }
 
 
+VertexBuffer::VertexBuffer()
+	: bufferID{}
+{}
+
+
 void VertexBuffer::uploadData(GLsizeiptr size, const void* data, GLenum usage) {
 	bind();
-	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	counters.uploads++;
+	counters.uploadedBytes += std::size_t(size);
+
+	GLsizeiptr target = allocated;
+	if (size > allocated) {
+		target = std::max(size, 2 * allocated);
+	}
+	else if (shrink == ShrinkPolicy::Quarter && 4 * size < allocated) {
+		target = 2 * size;
+	}
+	else if (shrink == ShrinkPolicy::Exact && size != allocated) {
+		target = size;
+	}
+
+	if (target == allocated && usage == allocatedUsage) {
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+		return;
+	}
+
+	counters.allocations++;
+	counters.allocatedBytes += std::size_t(target);
+	allocated = target;
+	allocatedUsage = usage;
+
+	if (target == size) {
+		glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	}
+	else {
+		glBufferData(GL_ARRAY_BUFFER, target, nullptr, usage);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, data);
+	}
 }
@@ -4,11 +4,30 @@
 
 #include <GL/glew.h>
 
+#include <cstddef>
 
+
+// What uploadData does with storage that is larger than the data
+enum class ShrinkPolicy {
+	Never,    // keep the largest storage ever needed
+	Quarter,  // reallocate at twice the data's size once it uses less than a quarter
+	Exact     // storage always matches the data, reallocated whenever the size changes
+};
+
+
+// Remembers how much storage it has, so uploads that fit go through
+// glBufferSubData and only growing past it (by doubling) or shrinking as the
+// policy says reallocates.
 class VertexBuffer {
 
 public:
-	VertexBuffer(GLuint index, GLint size, GLenum dataType);
+	// normalized integer data is mapped to [0, 1] (unsigned) or [-1, 1] (signed)
+	// when the shader reads it. A non-zero divisor makes this a per-instance
+	// attribute that advances once every divisor instances instead of once per vertex
+	VertexBuffer(GLuint index, GLint size, GLenum dataType, GLboolean normalized = GL_FALSE, GLuint divisor = 0);
+
+	// Just the buffer, for when the attributes are set up from a VertexLayout
+	VertexBuffer();
 
 	// Because we're using the VertexBufferHandle to do RAII for the buffer for us
 	// and our other types are trivial or provide their own RAII
@@ -21,7 +40,24 @@ public:
 	void bind() const { glBindBuffer(GL_ARRAY_BUFFER, bufferID); }
 	void uploadData(GLsizeiptr size, const void* data, GLenum usage);
 
+	void setShrinkPolicy(ShrinkPolicy policy) { shrink = policy; }
+	GLsizeiptr capacity() const { return allocated; }
+
+	// Counted over every VertexBuffer
+	struct Stats {
+		std::size_t uploads = 0;
+		std::size_t allocations = 0;
+		std::size_t uploadedBytes = 0;
+		std::size_t allocatedBytes = 0;
+	};
+	static const Stats& totals() { return counters; }
+
 private:
 	VertexBufferHandle bufferID;
+	GLsizeiptr allocated = 0;
+	GLenum allocatedUsage = 0;
+	ShrinkPolicy shrink = ShrinkPolicy::Quarter;
+
+	static Stats counters;
 };
 
@@ -0,0 +1,166 @@
+#pragma once
+
+//------------------------------------------------------------------------------
+// Vertex layouts described once, at compile time.
+//
+// A vertex is a plain struct. Its VertexLayout specialization lists which
+// member goes to which shader location, and applyVertexLayout<Vertex>() turns
+// that into the glVertexAttribPointer calls, with sizeof(Vertex) as the stride
+// and the member offsets. The component count, type and normalization come
+// from the member's type, so adding a layout is one struct and one list.
+//------------------------------------------------------------------------------
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/packing.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+
+// Packed attribute types
+struct Snorm16x2 { std::uint32_t bits; }; // x and y in [-1, 1] as 16 bit fixed point, x first
+struct Unorm8x4 { std::uint32_t bits; };  // RGBA8 colour, r first
+struct Unorm16 { std::uint16_t bits; };   // one value in [0, 1] as 16 bit fixed point
+
+
+// How the shader reads each attribute type
+template <typename T> struct AttributeFormat;
+
+template <> struct AttributeFormat<float> {
+	static constexpr GLint size = 1;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+};
+template <> struct AttributeFormat<glm::vec2> {
+	static constexpr GLint size = 2;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+};
+template <> struct AttributeFormat<glm::vec3> {
+	static constexpr GLint size = 3;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+};
+template <> struct AttributeFormat<glm::vec4> {
+	static constexpr GLint size = 4;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+};
+template <> struct AttributeFormat<Snorm16x2> {
+	static constexpr GLint size = 2;
+	static constexpr GLenum type = GL_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+};
+template <> struct AttributeFormat<Unorm8x4> {
+	static constexpr GLint size = 4;
+	static constexpr GLenum type = GL_UNSIGNED_BYTE;
+	static constexpr GLboolean normalized = GL_TRUE;
+};
+template <> struct AttributeFormat<Unorm16> {
+	static constexpr GLint size = 1;
+	static constexpr GLenum type = GL_UNSIGNED_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+};
+
+
+// One member of type T, Offset bytes into the vertex, read at shader location Location
+template <GLuint Location, typename T, std::size_t Offset>
+struct Attribute {
+	template <typename Vertex>
+	static void apply(GLintptr base) {
+		static_assert(Offset + sizeof(T) <= sizeof(Vertex), "attribute lies outside of the vertex");
+		using Format = AttributeFormat<T>;
+		glVertexAttribPointer(Location, Format::size, Format::type, Format::normalized, GLsizei(sizeof(Vertex)), (void*)(base + GLintptr(Offset)));
+		glEnableVertexAttribArray(Location);
+	}
+};
+
+template <typename... Attributes>
+struct AttributeList {
+	template <typename Vertex>
+	static void apply(GLintptr base) { (Attributes::template apply<Vertex>(base), ...); }
+};
+
+// Specialize with `using attributes = AttributeList<Attribute<...>, ...>;`
+template <typename Vertex> struct VertexLayout;
+
+
+// Sets up the attributes of Vertex for the currently bound VAO, reading from
+// the buffer currently bound to GL_ARRAY_BUFFER with the first vertex base bytes in
+template <typename Vertex>
+void applyVertexLayout(GLintptr base = 0) {
+	static_assert(std::is_standard_layout<Vertex>::value, "offsetof needs a standard layout vertex");
+	VertexLayout<Vertex>::attributes::template apply<Vertex>(base);
+}
+
+
+//------------------------------------------------------------------------------
+// The layouts GPU_Geometry uses. Positions go to location 0, colours to 1.
+// Colour map values (see ColorMapTexture) replace the colours at location 1.
+
+// Interleaved, one buffer
+struct FloatVertex { glm::vec3 pos; glm::vec3 col; };
+struct CompactVertex { Snorm16x2 pos; Unorm8x4 col; };
+
+// Split, one buffer each for positions and colours
+struct FloatPosition { glm::vec3 pos; };
+struct FloatColor { glm::vec3 col; };
+struct CompactPosition { Snorm16x2 pos; };
+struct CompactColor { Unorm8x4 col; };
+
+// Split, a value in place of a colour. Always 16 bit whatever the positions
+// are, a colour map has far fewer texels than that to tell apart.
+struct CompactValue { Unorm16 value; };
+
+template <> struct VertexLayout<FloatVertex> {
+	using attributes = AttributeList<
+		Attribute<0, glm::vec3, offsetof(FloatVertex, pos)>,
+		Attribute<1, glm::vec3, offsetof(FloatVertex, col)>>;
+};
+template <> struct VertexLayout<CompactVertex> {
+	using attributes = AttributeList<
+		Attribute<0, Snorm16x2, offsetof(CompactVertex, pos)>,
+		Attribute<1, Unorm8x4, offsetof(CompactVertex, col)>>;
+};
+template <> struct VertexLayout<FloatPosition> {
+	using attributes = AttributeList<Attribute<0, glm::vec3, offsetof(FloatPosition, pos)>>;
+};
+template <> struct VertexLayout<FloatColor> {
+	using attributes = AttributeList<Attribute<1, glm::vec3, offsetof(FloatColor, col)>>;
+};
+template <> struct VertexLayout<CompactPosition> {
+	using attributes = AttributeList<Attribute<0, Snorm16x2, offsetof(CompactPosition, pos)>>;
+};
+template <> struct VertexLayout<CompactColor> {
+	using attributes = AttributeList<Attribute<1, Unorm8x4, offsetof(CompactColor, col)>>;
+};
+template <> struct VertexLayout<CompactValue> {
+	using attributes = AttributeList<Attribute<1, Unorm16, offsetof(CompactValue, value)>>;
+};
+
+
+//------------------------------------------------------------------------------
+// Converting CPU_Geometry's vec3s into the attribute types
+
+inline void store(glm::vec3& dst, glm::vec3 v) { dst = v; }
+inline void store(Snorm16x2& dst, glm::vec3 v) { dst.bits = glm::packSnorm2x16(glm::vec2(v)); }
+inline void store(Unorm8x4& dst, glm::vec3 v) { dst.bits = glm::packUnorm4x8(glm::vec4(v, 1.f)); }
+inline void store(Unorm16& dst, float v) { dst.bits = std::uint16_t(glm::round(glm::clamp(v, 0.f, 1.f) * 65535.f)); }
+
+// Overwrite the pos or col member of the vertices, keeping whatever is already in
+// the other members. Positions decide how many vertices there are, colours only
+// grow vertices to fit since a scene may colour fewer vertices than it has.
+template <typename Vertex>
+void storePositions(std::vector<Vertex>& vertices, const std::vector<glm::vec3>& verts) {
+	vertices.resize(verts.size());
+	for (std::size_t i = 0; i < verts.size(); i++) store(vertices[i].pos, verts[i]);
+}
+
+template <typename Vertex>
+void storeColors(std::vector<Vertex>& vertices, const std::vector<glm::vec3>& cols) {
+	if (vertices.size() < cols.size()) vertices.resize(cols.size());
+	for (std::size_t i = 0; i < cols.size(); i++) store(vertices[i].col, cols[i]);
+}
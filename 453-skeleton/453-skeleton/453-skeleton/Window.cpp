@@ -39,6 +39,12 @@ void Window::windowSizeMetaCallback(GLFWwindow* window, int width, int height) {
 }
 
 
+void Window::windowRefreshMetaCallback(GLFWwindow* window) {
+	CallbackInterface* callbacks = static_cast<CallbackInterface*>(glfwGetWindowUserPointer(window));
+	callbacks->windowRefreshCallback();
+}
+
+
 // ----------------------
 // non-static definitions
 // ----------------------
@@ -95,6 +101,7 @@ void Window::connectCallbacks() {
 	glfwSetCursorPosCallback(window.get(), cursorPosMetaCallback);
 	glfwSetScrollCallback(window.get(), scrollMetaCallback);
 	glfwSetWindowSizeCallback(window.get(), windowSizeMetaCallback);
+	glfwSetWindowRefreshCallback(window.get(), windowRefreshMetaCallback);
 }
 
 
@@ -116,3 +123,10 @@ glm::ivec2 Window::getSize() const {
 	glfwGetWindowSize(window.get(), &w, &h);
 	return glm::ivec2(w, h);
 }
+
+
+glm::ivec2 Window::getFramebufferSize() const {
+	int w, h;
+	glfwGetFramebufferSize(window.get(), &w, &h);
+	return glm::ivec2(w, h);
+}
@@ -23,6 +23,7 @@ public:
 	virtual void cursorPosCallback(double xpos, double ypos) {}
 	virtual void scrollCallback(double xoffset, double yoffset) {}
 	virtual void windowSizeCallback(int width, int height) { glViewport(0, 0, width, height); }
+	virtual void windowRefreshCallback() {} // the contents were damaged and have to be drawn again
 };
 
 
@@ -59,6 +60,9 @@ public:
 	int getWidth() const { return getSize().x; }
 	int getHeight() const { return getSize().y; }
 
+	// In pixels, which on high DPI screens is more than getSize()
+	glm::ivec2 getFramebufferSize() const;
+
 	int shouldClose() { return glfwWindowShouldClose(window.get()); }
 	void makeContextCurrent() { glfwMakeContextCurrent(window.get()); }
 	void swapBuffers() { glfwSwapBuffers(window.get()); }
@@ -78,5 +82,6 @@ private:
 	static void cursorPosMetaCallback(GLFWwindow* window, double xpos, double ypos);
 	static void scrollMetaCallback(GLFWwindow* window, double xoffset, double yoffset);
 	static void windowSizeMetaCallback(GLFWwindow* window, int width, int height);
+	static void windowRefreshMetaCallback(GLFWwindow* window);
 };
 
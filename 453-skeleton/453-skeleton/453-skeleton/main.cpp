@@ -8,40 +8,310 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <argh.h>
+#include "AllocationCounter.h"
+#include "BatchedGeometry.h"
+#include "Camera.h"
+#include "ChunkedFractals.h"
+#include "ChunkStream.h"
+#include "ColorMapTexture.h"
+#include "Fractals.h"
 #include "Geometry.h"
+#include "GenerationWorker.h"
 #include "GLDebug.h"
+#include "GpuGenerator.h"
+#include "IncrementalFractals.h"
+#include "LodFractals.h"
 #include "Log.h"
+#include "OffscreenTarget.h"
+#include "Profiler.h"
 #include "ShaderProgram.h"
 #include "Shader.h"
+#include "StreamBuffer.h"
+#include "ThreadPool.h"
 #include "Window.h"
 
 
 // Scene 1 = Serpinsky Triangle, Scene 2 = Square Diamond, Scene 3 = Koch Snowflake
 struct State {
-	// There is this really weird bug where it doesn't draw at the iteration it is set to and I have no clue why it does that
 	int iterations = 0;
 	int scene = 1;
 	bool operator == (State const& other) const {
-		return iterations == other.iterations;
+		return iterations == other.iterations && scene == other.scene;
 	}
 };
 
-// Random float between 0 and 1 found at https://stackoverflow.com/questions/9878965/rand-between-0-and-1
-float randomFloat() {
-	float r = ((float) rand() / (RAND_MAX));
-	return r;
+// Command line options, see README.txt
+struct Options {
+	// Draw the Serpinsky triangle as copies of a base mesh instead of every triangle
+	bool instanced = false;
+	int instanceBase = 5;
+
+	// Store vertices as 16 bit positions and RGBA8 colours instead of floats
+	VertexFormat vertexFormat = VertexFormat::Float;
+
+	// Keep positions and colours interleaved in one buffer instead of one each
+	BufferLayout bufferLayout = BufferLayout::Split;
+
+	// Upload through ring buffers that never wait for the GPU to finish with older data
+	UploadMode uploadMode = UploadMode::Static;
+
+	// When vertex buffers give back storage they no longer need
+	ShrinkPolicy shrinkPolicy = ShrinkPolicy::Quarter;
+
+	// Draw the Serpinsky triangle from shared corners and an index buffer
+	bool indexed = false;
+
+	// Work out the Serpinsky triangle's colours in the vertex shader instead of uploading them
+	bool shaderColors = false;
+
+	// Give every vertex a value to look up in this ColorMapTexture layer instead of a colour, -1 for colours
+	int colormap = -1;
+
+	// Generate the Serpinsky triangle and Koch snowflake with transform feedback
+	bool gpuGenerator = false;
+
+	// Check every Serpinsky level the GPU generates against the CPU's
+	bool compareGenerators = false;
+
+	// Generate on the render thread instead of the worker's
+	bool syncGeneration = false;
+
+	// Memory for levels the worker generates before they are asked for
+	std::size_t prefetchBudget = std::size_t(256) << 20;
+
+	// Generate, upload and draw scenes a chunk at a time instead of all at once
+	bool chunked = false;
+
+	// Memory a level may take. It bounds the chunk pool when chunked, and how deep
+	// the arrow keys go otherwise.
+	std::size_t memoryBudget = std::size_t(512) << 20;
+
+	// Vertices a chunked level may have, since every redraw generates all of them again
+	std::size_t chunkedVertexBudget = std::size_t(64) * 1000000;
+
+	// Stop subdividing primitives smaller than this many pixels, 0 for never
+	float lodPixels = 0.f;
+
+	// With LOD, generate in double relative to the camera so it can zoom in much further
+	bool deepZoom = false;
+
+	// Log frame timings, and write every sample to a CSV file if there is a path
+	bool profile = false;
+	std::string profileCsv;
+
+	// Render into a framebuffer object behind a hidden window, optionally saving the last frame
+	bool headless = false;
+	std::string screenshot;
+
+	// Stop after this many frames, 0 runs until the window is closed
+	int frames = 0;
+
+	// What is on screen before any key is pressed
+	State initialState;
+};
+
+// Vertices of a whole level of a scene
+std::size_t levelVertices(int scene, int iterations) {
+	if (scene == 1) return 3 * serpinskyTriangleCount(iterations);
+	if (scene == 2) return squareDiamondVertexCount(iterations);
+	return 3 * 2 * snowflakeSegmentCount(iterations);
+}
+
+// Deepest level of a scene, up to MAX_CHUNKED_ITERATIONS, whose vertices take
+// at most budget at vertexCost each
+int deepestLevelWithin(int scene, std::size_t vertexCost, std::size_t budget) {
+	int iterations = 0;
+	while (iterations < MAX_CHUNKED_ITERATIONS && levelVertices(scene, iterations + 1) * vertexCost <= budget) {
+		iterations++;
+	}
+	return iterations;
+}
+
+// Bytes a vertex of a level takes everywhere the worker's scenes keep it at
+// the same time. Every copy keeps its storage from one level to the next.
+// Prefetched levels come on top of this, within --prefetch.
+std::size_t residentVertexBytes(const Options& options, int scene) {
+	std::size_t cpuCopy = 2 * sizeof(glm::vec3);
+
+	std::size_t bytes = cpuCopy      // the worker's IncrementalFractal
+		+ 3 * cpuCopy                // the TripleBuffer slots it publishes through
+		+ (options.vertexFormat == VertexFormat::Compact ? 8 : 24); // on the GPU
+
+	// SerpinskyLevels refines into scratch positions and keeps them. A side of
+	// the snowflake keeps two KochBuffers polylines of a point per 2 vertices,
+	// and BatchedGeometry packs the three sides into one more copy.
+	if (scene == 1) bytes += sizeof(glm::vec3);
+	if (scene == 3) bytes += 2 * sizeof(float) + cpuCopy;
+	return bytes;
+}
+
+// Deepest level of a scene the arrow keys go to. With LOD, only the levels
+// above a pixel are generated, so their memory doesn't grow. Chunked, a level takes the same
+// memory however deep it is, but every redraw generates all of it, so it is its
+// vertex count that is bounded. Otherwise every copy of it has to fit in the
+// budget, see residentVertexBytes.
+int maxIterations(const Options& options, int scene) {
+	if (options.lodPixels > 0.f) return MAX_LOD_ITERATIONS;
+	if (options.chunked) return deepestLevelWithin(scene, 1, options.chunkedVertexBudget);
+
+	int iterations = deepestLevelWithin(scene, residentVertexBytes(options, scene), options.memoryBudget);
+	if (scene == 1 && options.indexed) iterations = std::min(iterations, MAX_INDEXED_SERPINSKY_ITERATIONS);
+	return iterations;
+}
+
+Options parseOptions(int argc, char** argv) {
+	argh::parser cmdl(argc, argv);
+	Options options;
+
+	options.instanced = cmdl["--instanced"];
+	options.indexed = cmdl["--indexed"];
+	options.shaderColors = cmdl["--shader-colors"];
+	if (cmdl["--compact"]) options.vertexFormat = VertexFormat::Compact;
+	if (cmdl["--interleaved"]) options.bufferLayout = BufferLayout::Interleaved;
+
+	std::string colormap;
+	if (cmdl["--colormap"]) colormap = "viridis";
+	cmdl("--colormap") >> colormap;
+	if (!colormap.empty()) {
+		options.colormap = ColorMapTexture::find(colormap);
+		if (options.colormap < 0) {
+			Log::warn("Unknown --colormap={}, using viridis", colormap);
+			options.colormap = ColorMapTexture::find("viridis");
+		}
+		if (options.bufferLayout == BufferLayout::Interleaved) {
+			// Values replace the colour buffer, interleaved there is none
+			Log::warn("--colormap needs a buffer of its own for the values, not using --interleaved");
+			options.bufferLayout = BufferLayout::Split;
+		}
+		if (options.shaderColors) {
+			Log::warn("--colormap colours the Serpinsky triangle as well, ignoring --shader-colors");
+			options.shaderColors = false;
+		}
+	}
+	if (cmdl["--streaming"]) options.uploadMode = UploadMode::Streaming;
+
+	std::string shrink;
+	cmdl("--shrink", "quarter") >> shrink;
+	if (shrink == "never") options.shrinkPolicy = ShrinkPolicy::Never;
+	else if (shrink == "exact") options.shrinkPolicy = ShrinkPolicy::Exact;
+	else if (shrink != "quarter") Log::warn("Unknown --shrink={}, using quarter", shrink);
+	cmdl("--instance-base", options.instanceBase) >> options.instanceBase;
+	options.instanceBase = std::max(options.instanceBase, 0);
+
+	options.profile = cmdl["--profile"];
+	cmdl("--profile-csv") >> options.profileCsv;
+
+	options.headless = cmdl["--headless"];
+	cmdl("--screenshot") >> options.screenshot;
+	cmdl("--frames", options.frames) >> options.frames;
+	options.frames = std::max(options.frames, 0);
+	if (options.headless && options.frames == 0) {
+		// Nothing could ever close it
+		Log::warn("--headless without --frames, rendering 600 frames");
+		options.frames = 600;
+	}
+	if (!options.screenshot.empty() && !options.headless) {
+		Log::warn("--screenshot only works with --headless, ignored");
+	}
+
+	cmdl("--scene", options.initialState.scene) >> options.initialState.scene;
+	options.initialState.scene = std::clamp(options.initialState.scene, 1, 3);
+
+	options.syncGeneration = cmdl["--sync-generation"];
+	int prefetchMB = 256;
+	cmdl("--prefetch", prefetchMB) >> prefetchMB;
+	options.prefetchBudget = std::size_t(std::max(prefetchMB, 0)) << 20;
+
+	options.chunked = cmdl["--chunked"];
+	int memoryMB = 512;
+	cmdl("--memory", memoryMB) >> memoryMB;
+	options.memoryBudget = std::size_t(std::max(memoryMB, 1)) << 20;
+	int chunkedMillions = 64;
+	cmdl("--chunked-vertices", chunkedMillions) >> chunkedMillions;
+	options.chunkedVertexBudget = std::size_t(std::max(chunkedMillions, 1)) * 1000000;
+
+	if (cmdl["--lod"]) options.lodPixels = 1.f;
+	cmdl("--lod") >> options.lodPixels;
+	options.lodPixels = std::max(options.lodPixels, 0.f);
+	options.deepZoom = cmdl["--deep-zoom"];
+	if (options.deepZoom && options.lodPixels == 0.f) options.lodPixels = 1.f;
+	if (options.deepZoom && options.vertexFormat == VertexFormat::Compact) {
+		// Relative to the camera, vertices of primitives sticking out of the window are outside [-1, 1]
+		Log::warn("--compact can't store what --deep-zoom generates, using floats");
+		options.vertexFormat = VertexFormat::Float;
+	}
+
+	std::string generator;
+	cmdl("--generator", "cpu") >> generator;
+	options.gpuGenerator = (generator == "gpu");
+	if (generator != "cpu" && generator != "gpu") {
+		Log::warn("Unknown --generator={}, using cpu", generator);
+	}
+	options.compareGenerators = cmdl["--compare"];
+	if (options.compareGenerators && !options.gpuGenerator) {
+		Log::warn("--compare only works with --generator=gpu, ignored");
+	}
+
+	// Shader colours are only worked out for the Serpinsky triangle drawn whole
+	// from the worker's scenes, the other ways of drawing it upload colours
+	if (options.shaderColors) {
+		const char* other = options.chunked ? "--chunked" : (options.lodPixels > 0.f) ? "--lod"
+			: options.gpuGenerator ? "--generator=gpu" : options.instanced ? "--instanced" : options.indexed ? "--indexed" : nullptr;
+		if (other != nullptr) {
+			Log::warn("--shader-colors doesn't work with {}, ignored", other);
+			options.shaderColors = false;
+		}
+	}
+
+	// Colour map values are only uploaded with the worker's scenes
+	if (options.colormap >= 0 && (options.chunked || options.lodPixels > 0.f)) {
+		Log::warn("--colormap doesn't work with {}, ignored", options.chunked ? "--chunked" : "--lod");
+		options.colormap = -1;
+	}
+	else if (options.colormap >= 0) {
+		if (options.gpuGenerator) Log::warn("--colormap only colours the square diamond with --generator=gpu");
+		else if (options.instanced || options.indexed) {
+			Log::warn("--colormap doesn't colour the Serpinsky triangle with {}", options.instanced ? "--instanced" : "--indexed");
+		}
+	}
+
+	// Depends on how levels are stored, so only once all of that is known
+	cmdl("--iterations", options.initialState.iterations) >> options.initialState.iterations;
+	options.initialState.iterations = std::clamp(options.initialState.iterations, 0,
+		maxIterations(options, options.initialState.scene));
+
+	return options;
 }
 
 // EXAMPLE CALLBACKS
 class MyCallbacks : public CallbackInterface {
 
 public:
-	MyCallbacks(ShaderProgram& shader) : shader(shader) {}
+	MyCallbacks(ShaderProgram& shader, const Options& options)
+		: state(options.initialState), colormap(options.colormap), shader(shader), options(options)
+	{
+		// About 2^43, where the level 50 triangles of the deepest level are still
+		// a few pixels and double can still tell their corners apart
+		if (options.deepZoom) camera.maxZoom = 1e13;
+	}
 
 	virtual void keyCallback(int key, int scancode, int action, int mods) {
 		if (action == GLFW_PRESS || action == GLFW_REPEAT) {
 			if (key == GLFW_KEY_R) {
 				shader.recompile();
+				redraw = true;
+			}
+			if (key == GLFW_KEY_HOME) {
+				camera.reset();
+				redraw = true;
+			}
+			if (key == GLFW_KEY_C && colormap >= 0) {
+				colormap = (colormap + 1) % ColorMapTexture::count();
+				Log::info("Colour map {}", ColorMapTexture::name(colormap));
+				redraw = true;
 			}
 			if (key == GLFW_KEY_LEFT) {
 				if (state.iterations > 0) {
@@ -49,7 +319,7 @@ public:
 				}
 			}
 			if (key == GLFW_KEY_RIGHT) {
-				if (state.iterations < 10) {
+				if (state.iterations < maxIterations(options, state.scene)) {
 					state.iterations++;
 				}
 			}
@@ -57,226 +327,183 @@ public:
 			if (key == GLFW_KEY_1) {
 				if (state.scene != 1) {
 					state.scene = 1;
+					state.iterations = std::min(state.iterations, maxIterations(options, state.scene));
 				}
 			}
 
 			if (key == GLFW_KEY_2) {
 				if (state.scene != 2) {
 					state.scene = 2;
+					state.iterations = std::min(state.iterations, maxIterations(options, state.scene));
 				}
 			}
 
 			if (key == GLFW_KEY_3) {
 				if (state.scene != 3) {
 					state.scene = 3;
+					state.iterations = std::min(state.iterations, maxIterations(options, state.scene));
 				}
 			}
 
 		}
 	}
-	State getState() {
-		return state;
+	// Scrolling zooms in and out around the cursor
+	virtual void scrollCallback(double xoffset, double yoffset) {
+		camera.zoomAt(toClip(cursor), std::pow(1.25, yoffset));
+		redraw = true;
 	}
 
-private:
-	State state;
-	ShaderProgram& shader;
-};
+	// Dragging with the left button moves the scene with the cursor
+	virtual void mouseButtonCallback(int button, int action, int mods) {
+		if (button == GLFW_MOUSE_BUTTON_LEFT) dragging = (action == GLFW_PRESS);
+	}
 
+	virtual void cursorPosCallback(double xpos, double ypos) {
+		glm::dvec2 position(xpos, ypos);
+		if (dragging) {
+			camera.pan(toClip(position) - toClip(cursor));
+			redraw = true;
+		}
+		cursor = position;
+	}
 
-// END EXAMPLES
+	virtual void windowSizeCallback(int width, int height) {
+		CallbackInterface::windowSizeCallback(width, height);
+		windowSize = glm::dvec2(width, height);
+		redraw = true;
+	}
 
+	virtual void windowRefreshCallback() {
+		redraw = true;
+	}
 
-// Colors
-glm::vec3 const RED = glm::vec3(1.f, 0.f, 0.f);
-glm::vec3 const GREEN = glm::vec3(0.f, 1.f, 0.f);
-glm::vec3 const BLUE = glm::vec3(0.f, 0.f, 1.f);
-glm::vec3 const BLACK = glm::vec3(0.f, 0.f, 0.f);
-glm::vec3 const YELLOW = glm::vec3(1.f, 1.f, 0.f);
+	State getState() {
+		return state;
+	}
 
-// Helper function for entering points as data
-glm::vec3 point(std::vector<float> point) {
-	return glm::vec3(point[0], point[1], 0.f);
-}
+	const Camera2D& getCamera() const { return camera; }
 
-// Point rotation referenced from https://www.geeksforgeeks.org/basic-transformations-opengl/#:~:text=To%20rotate%20around%20a%20different,x%2C%20y%2C%20z).
-std::vector<float> rotatePoint(std::vector<float> point, std::vector<float> pivot, float angle) {
-	int x = 0;
-	int y = 1;
+	// The ColorMapTexture layer to colour with, -1 without --colormap
+	int getColormap() const { return colormap; }
 
-	float angleInRadians = angle * (float)(M_PI / 180.f);
-	float rotatedX = pivot[x] + (point[x] - pivot[x]) * cos(angleInRadians) - (point[y] - pivot[y]) * sin(angleInRadians);
-	float rotatedY = pivot[x] + (point[x] - pivot[x]) * sin(angleInRadians) + (point[y] - pivot[y])* cos(angleInRadians);
+	// Whether something other than the state needs the picture drawn again
+	bool needsRedraw() const { return redraw; }
 
-	std::vector<float> newPoint{ rotatedX, rotatedY };
-	return newPoint;
-}
+	bool takeRedraw() {
+		bool was = redraw;
+		redraw = false;
+		return was;
+	}
 
-// Gets a point in between p and q given an alpha value
-std::vector<float> pointOnLine(float alpha, std::vector<float> p, std::vector<float> q) {
-	int x = 0;
-	int y = 1;
+private:
+	State state;
+	int colormap;
+	bool redraw = true; // nothing is on screen yet
+	ShaderProgram& shader;
 
-	float newX = (float)(1 - alpha) * p[x] + alpha * q[x];
-	float newY = (float)(1 - alpha) * p[y] + alpha * q[y];
+	Camera2D camera;
+	glm::dvec2 windowSize = glm::dvec2(800.0, 800.0); // in the same screen coordinates as the cursor
+	glm::dvec2 cursor = glm::dvec2(0.0);
+	bool dragging = false;
 
-	std::vector<float> newPoint{ newX, newY };
-	return newPoint;
-}
+	// Cursor positions start at the top left, clip space in the middle going up
+	glm::dvec2 toClip(glm::dvec2 position) const {
+		return glm::dvec2(2.0 * position.x / windowSize.x - 1.0, 1.0 - 2.0 * position.y / windowSize.y);
+	}
+	const Options& options;
+};
 
-// Calculates vector made by two points
-std::vector<float> getVectorFromPoints(std::vector<float> p, std::vector<float> q) {
-	float firstElement = q[0] - p[0];
-	float secondElement = q[1] - p[1];
-	std::vector<float> vector{ firstElement, secondElement };
-	return vector;
-}
 
-// Moves a point along a vector
-std::vector<float> getPointFromVector(std::vector<float> point, glm::vec3 vector) {
-	float newX = point[0] + (float)vector.x;
-	float newY = point[1] + (float)vector.y;
-	std::vector<float> newPoint{ newX, newY };
-	return newPoint;
-}
+// END EXAMPLES
 
-// Gets points for square diamond
-glm::vec3 squareDiamondPoint(std::vector<float> point, float factor) {
-	return glm::vec3((point[0] * factor), (point[1] * factor), 0.f);
-}
 
+// Reads back the Serpinsky level the GPU generated last and checks it against
+// generateSerpinskyIterative and colorSerpinsky. Positions have to match exactly,
+// colours to within rounding since GLSL division doesn't have to be exact.
+bool compareSerpinsky(const GpuFractalGenerator& gpu, glm::vec2 a, glm::vec2 b, glm::vec2 c, int iterations) {
+	std::vector<glm::vec3> gpuVerts;
+	std::vector<glm::vec3> gpuCols;
+	gpu.readVerts(gpuVerts, gpuCols);
 
-// Gets midpoint of two vertices
-std::vector<float> midPoint(std::vector<float> vertex1, std::vector<float> vertex2) {
-	std::vector<float> point;
-	for (int i = 0; i < 2; i++) point.push_back((vertex1[i] * 0.5) + (vertex2[i] * 0.5));
-	return point;
-}
+	CPU_Geometry cpu;
+	generateSerpinskyIterative(a, b, c, cpu, iterations);
+	colorSerpinsky(cpu, iterations);
 
-void generateSerpinsky(std::vector<float> a, std::vector<float> b, std::vector<float> c, CPU_Geometry& triangle, int iterations) {
-	if (iterations > 0) {
-		std::vector<float> d = midPoint(a, b);
-		std::vector<float> e = midPoint(a, c);
-		std::vector<float> f = midPoint(b, c);
-		generateSerpinsky(a, d, e, triangle, iterations - 1);
-		generateSerpinsky(d, b, f, triangle, iterations - 1);
-		generateSerpinsky(e, f, c, triangle, iterations - 1);
-	}
-	else {
-		triangle.verts.push_back(glm::vec3(a[0], a[1], 0.f));
-		triangle.verts.push_back(glm::vec3(b[0], b[1], 0.f));
-		triangle.verts.push_back(glm::vec3(c[0], c[1], 0.f));
+	if (gpuVerts.size() != cpu.verts.size()) {
+		Log::error("COMPARE serpinsky level {}: {} vertices on the GPU, {} on the CPU", iterations, gpuVerts.size(), cpu.verts.size());
+		return false;
 	}
-}
 
-void serpinskyAllColored(CPU_Geometry& triangle) {
-	for (int vert = 0; vert < triangle.verts.size(); vert++) triangle.cols.push_back(glm::vec3(randomFloat(), randomFloat(), randomFloat()));
-}
-
-void colorAllVerts(CPU_Geometry& cpuGeom, glm::vec3 color) {
-	for (int vert = 0; vert < cpuGeom.verts.size(); vert++) cpuGeom.cols.push_back(color);
-}
-
-void generateSquareDiamond(CPU_Geometry& squareDiamond, int iterations, std::vector<std::vector<float>> initialPoints) {
-	// An interesting observation I made is that the next 2 shapes are half the size of the first 2
-	float factor = 0.5f;
-
-	for (int i = 0; i < initialPoints.size(); i++) squareDiamond.verts.push_back(point(initialPoints[i]));
-
-	for (int i = 0; i < iterations; i++) {
-		for (int j = 0; j < initialPoints.size(); j++) squareDiamond.verts.push_back(squareDiamondPoint(initialPoints[j], factor));
-		squareDiamond.cols.push_back(BLUE);
-		squareDiamond.cols.push_back(BLUE);
-		squareDiamond.cols.push_back(BLUE);
-		squareDiamond.cols.push_back(BLUE);
-		squareDiamond.cols.push_back(BLUE);
-		squareDiamond.cols.push_back(RED);
-		squareDiamond.cols.push_back(RED);
-		squareDiamond.cols.push_back(RED);
-		squareDiamond.cols.push_back(RED);
-		squareDiamond.cols.push_back(RED);
-		factor *= 0.5f;
+	std::size_t positions = 0;
+	std::size_t colors = 0;
+	std::size_t firstMismatch = gpuVerts.size();
+	for (std::size_t i = 0; i < gpuVerts.size(); i++) {
+		bool position = gpuVerts[i] != cpu.verts[i];
+		bool color = glm::any(glm::greaterThan(glm::abs(gpuCols[i] - cpu.cols[i]), glm::vec3(1e-5f)));
+		positions += position;
+		colors += color;
+		if ((position || color) && firstMismatch == gpuVerts.size()) firstMismatch = i;
 	}
 
-	
-}
-
-// Function to generate geometry for koch snowflake
-void generateSnowflake(CPU_Geometry& snowflake, std::vector<float> startingPoint, std::vector<float> endingPoint, glm::vec3 color, int iterations) {
-	float firstPointAlpha = 1.f / 3.f;
-	float lastPointAlpha = 2.f / 3.f;
-	float endPointAlpha = 1.f;
-	if (iterations > 0) {
-		std::vector<float> firstPoint = pointOnLine(firstPointAlpha, startingPoint, endingPoint);
-		std::vector<float> lastPoint = pointOnLine(lastPointAlpha, startingPoint, endingPoint);
-		std::vector<float> middle = rotatePoint(firstPoint, lastPoint, 60.0);
-
-
-		generateSnowflake(snowflake, startingPoint, firstPoint, BLUE,iterations - 1);
-		generateSnowflake(snowflake, firstPoint, middle, GREEN, iterations - 1);
-		generateSnowflake(snowflake, middle, lastPoint, RED, iterations - 1);
-		generateSnowflake(snowflake, lastPoint, endingPoint, YELLOW, iterations - 1);
-	}
-	else {
-		snowflake.verts.push_back(point(startingPoint));
-		snowflake.verts.push_back(point(endingPoint));
-		snowflake.cols.push_back(color);
-		snowflake.cols.push_back(color);
+	if (positions == 0 && colors == 0) {
+		Log::info("COMPARE serpinsky level {}: all {} vertices match the CPU", iterations, gpuVerts.size());
+		return true;
 	}
+	std::size_t i = firstMismatch;
+	Log::error("COMPARE serpinsky level {}: {} positions and {} colours of {} vertices differ from the CPU, first vertex {}: "
+		"({}, {}, {}) ({}, {}, {}) on the GPU, ({}, {}, {}) ({}, {}, {}) on the CPU",
+		iterations, positions, colors, gpuVerts.size(), i,
+		gpuVerts[i].x, gpuVerts[i].y, gpuVerts[i].z, gpuCols[i].r, gpuCols[i].g, gpuCols[i].b,
+		cpu.verts[i].x, cpu.verts[i].y, cpu.verts[i].z, cpu.cols[i].r, cpu.cols[i].g, cpu.cols[i].b);
+	return false;
 }
 
-void clearScene(CPU_Geometry& triangles, CPU_Geometry& squareDiamond, CPU_Geometry& snowflake1, CPU_Geometry& snowflake2, CPU_Geometry& snowflake3) {
-	triangles.verts.clear();
-	triangles.cols.clear();
-
-	squareDiamond.verts.clear();
-	squareDiamond.cols.clear();
-
-	snowflake1.verts.clear();
-	snowflake1.cols.clear();
-
-	snowflake2.verts.clear();
-	snowflake2.cols.clear();
-
-	snowflake3.verts.clear();
-	snowflake3.cols.clear();
-}
-
-int main() {
-	Log::debug("Starting main");
 
+// Everything that needs the GL context. The worker thread is joined and every
+// GL object is gone by the time it returns, so GLFW can be terminated after it.
+// Returns how many scopes allocated that were expected not to (see AllocationCounter.h).
+std::uint64_t run(const Options& options) {
 	// WINDOW
-	glfwInit();
+	if (options.headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // only there for the GL context
 	Window window(800, 800, "CPSC 453"); // can set callbacks at construction if desired
 
 	GLDebug::enable();
 
 	// SHADERS
 	ShaderProgram shader("shaders/test.vert", "shaders/test.frag");
+	ShaderProgram instancedShader("shaders/instanced.vert", "shaders/test.frag");
+	ShaderProgram serpinskyShader("shaders/serpinsky.vert", "shaders/test.frag");
+	ShaderProgram colormapShader("shaders/colormap.vert", "shaders/colormap.frag");
+
+	// Only made when it is used, it is the only texture
+	std::unique_ptr<ColorMapTexture> colormaps;
+	if (options.colormap >= 0) {
+		colormaps = std::make_unique<ColorMapTexture>();
+		colormaps->bind(0);
+		colormapShader.use();
+		glUniform1i(colormapShader.uniformLocation("colormap"), 0);
+	}
+	std::vector<float> colormapValues; // reused for every upload
+	std::vector<float> partValues;
 
 	// CALLBACKS
-	auto callbacks = std::make_shared<MyCallbacks>(shader);
+	auto callbacks = std::make_shared<MyCallbacks>(shader, options);
 	window.setCallbacks(callbacks); // can also update callbacks to new ones
 
-	// GEOMETRY
-	CPU_Geometry triangles;
-	GPU_Geometry trianglesGPU;
-
-	CPU_Geometry snowflake1;
-	GPU_Geometry snowflake1GPU;
-	CPU_Geometry snowflake2;
-	GPU_Geometry snowflake2GPU;
-	CPU_Geometry snowflake3;
-	GPU_Geometry snowflake3GPU;
+	if (options.uploadMode == UploadMode::Streaming) {
+		Log::info("Streaming uploads with {}", StreamBuffer::persistentSupported()
+			? "persistent mapped buffer storage" : "orphaned unsynchronized buffer ranges");
+	}
 
-	CPU_Geometry squareDiamond;
-	GPU_Geometry squareDiamondGPU;
+	Profiler profiler(options.profile, options.profileCsv);
 
+	// Workers for splitting up scene generation
+	ThreadPool pool;
 
 	// Initial triangle points for serpinsky triangle and koch snowflake
-	std::vector<float> second{ -0.5, -0.5 };
-	std::vector<float> third{ 0.5, -0.5 };
-	std::vector<float> first{ 0.0, 0.5 };
+	glm::vec2 const first(0.f, 0.5f);
+	glm::vec2 const second(-0.5f, -0.5f);
+	glm::vec2 const third(0.5f, -0.5f);
 
 	// Initial points for square
 	std::vector<float> point1{ 0.5, 0.5 };
@@ -292,67 +519,386 @@ int main() {
 
 	std::vector<std::vector<float>> squareDiamondPoints{point1, point2, point3, point4, point1, point5, point6, point7, point8, point5};
 
+	// GEOMETRY
+	// The scenes are generated on the worker's thread, which keeps every scene at
+	// its last level, so changing the iterations only derives the new level from
+	// the previous one instead of generating it from scratch. It wakes up the
+	// render loop whenever it has something new.
+	GenerationWorker worker(first, second, third, squareDiamondPoints, &pool, !options.syncGeneration, glfwPostEmptyEvent);
+	worker.setPrefetch(options.prefetchBudget, [&options](int scene) { return maxIterations(options, scene); });
+
+	// Every scene the worker made stays resident on the GPU, so switching back
+	// to one only draws it again. All parts of a scene share one batch.
+	struct ResidentScene {
+		GLenum mode;
+		std::unique_ptr<BatchedGeometry> batch;
+		int level = -1;
+	};
+	ResidentScene resident[] = { { GL_TRIANGLES }, { GL_LINE_STRIP }, { GL_LINE_STRIP } }; // scenes 1 to 3
+	int shownScene = 0; // the resident scene on screen, 0 for none
+
+	// What the worker was asked for last, and what it finished last
+	State requested;
+	State generated;
+	requested.scene = generated.scene = 0;
+
+	// For --instanced and --indexed the Serpinsky triangle is made right here instead
+	SerpinskyLevels triangles(first, second, third);
+	GPU_Geometry trianglesGPU(options.vertexFormat, options.bufferLayout, options.uploadMode);
+	trianglesGPU.setShrinkPolicy(options.shrinkPolicy);
+
+	// For --instanced, triangles only goes up to the base level and everything
+	// deeper is a copy of it placed by one of these
+	std::vector<glm::vec3> instances;
+	int instancedLevel = -1;
+	int uploadedBase = -1;
+
+	// For --indexed, every corner is stored once and the triangles index into them
+	CPU_Geometry indexedTriangles;
+	std::vector<std::uint32_t> triangleIndices;
+	int indexedLevel = -1;
+
+	// For --generator=gpu, scenes 1 and 3 never leave the GPU. It only keeps the
+	// last generated scene and level, so only regenerate when one of those changes.
+	std::unique_ptr<GpuFractalGenerator> gpuGenerator;
+	if (options.gpuGenerator) gpuGenerator = std::make_unique<GpuFractalGenerator>();
+	int gpuScene = -1;
+	int gpuLevel = -1;
+
+	// For --chunked every scene is drawn a chunk at a time, all chunks sharing a
+	// pool sized to fit in the memory budget
+	std::unique_ptr<ChunkStream> chunkStream;
+	std::unique_ptr<ChunkedFractal> chunkedScenes[3];
+	if (options.chunked) {
+		chunkStream = std::make_unique<ChunkStream>(options.memoryBudget, options.vertexFormat, options.bufferLayout, &pool);
+		chunkedScenes[0] = std::make_unique<ChunkedSerpinsky>(first, second, third);
+		chunkedScenes[1] = std::make_unique<ChunkedSquareDiamond>(squareDiamondPoints);
+		chunkedScenes[2] = std::make_unique<ChunkedSnowflake>(first, second, third);
+		Log::info("CHUNKED {} slots of up to {} vertices in {} bytes",
+			chunkStream->slotCount(), chunkStream->chunkVertices(), options.memoryBudget);
+	}
+	State chunkedState;
+	chunkedState.scene = 0;
+
+	// For --lod every scene is generated right here down to the pixel threshold,
+	// again whenever the level or the size of the viewport changes
+	CPU_Geometry lodGeometry;
+	GPU_Geometry lodGPU(options.vertexFormat, options.bufferLayout, options.uploadMode);
+	lodGPU.setShrinkPolicy(options.shrinkPolicy);
+	LodStats lodStats;
+	State lodState;
+	lodState.scene = 0;
+	glm::ivec2 lodViewport(0);
+	Camera2D lodCamera;
+
+	// For --headless everything is drawn into this instead of the hidden window
+	std::unique_ptr<OffscreenTarget> offscreen;
+	if (options.headless) {
+		offscreen = std::make_unique<OffscreenTarget>(800, 800);
+		offscreen->bind();
+	}
+
+	// Everything but the modes above goes through the worker
+	auto fromWorker = [&](const State& s) {
+		if (options.chunked || options.lodPixels > 0.f) return false;
+		if (gpuGenerator && (s.scene == 1 || s.scene == 3)) return false;
+		return !(s.scene == 1 && (options.instanced || options.indexed));
+	};
+
+	// What the last frame showed
 	State state;
 
+	// With --frames every frame is drawn, so it can be timed. Otherwise the loop
+	// sleeps in glfwWaitEvents until the state changes or the window needs repainting.
+	bool continuous = (options.frames > 0);
+
 	// RENDER LOOP
-	while (!window.shouldClose()) {
-		glfwPollEvents();
+	int frame = 0;
+	auto loopStart = std::chrono::steady_clock::now();
+	while (!window.shouldClose() && (options.frames == 0 || frame < options.frames)) {
+		if (!continuous && !callbacks->needsRedraw() && state == callbacks->getState()) {
+			glfwWaitEvents(); // the worker posts an empty event when it's done
+		}
+		profiler.beginFrame();
+
+		{
+			ProfileScope scope(profiler, "events");
+			glfwPollEvents();
+		}
+
+		bool changed = !(state == callbacks->getState());
+		bool redraw = callbacks->takeRedraw();
+		state = callbacks->getState();
+
+		// The old picture stays up until the worker has the new one
+		if (changed && fromWorker(state)) {
+			if (requested == generated && resident[state.scene - 1].level == state.iterations) {
+				shownScene = state.scene;
+			}
+			else {
+				worker.request(state.scene, state.iterations);
+				requested = state;
+			}
+		}
+		bool arrived = worker.update();
+
+		if (!continuous && !changed && !redraw && !arrived) continue;
+
+		frame++;
+		AllocationScope frameAllocations(changed ? "frame" : "redraw");
 
-		glEnable(GL_FRAMEBUFFER_SRGB);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		// Everything up to the swap, on the GPU
+		{
+			GpuProfileScope gpuScope(profiler, "render");
 
-		shader.use();
+			glEnable(GL_FRAMEBUFFER_SRGB);
+			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		if (!(state == callbacks->getState())) {
-			if (callbacks->getState().scene == 1) {
-				clearScene(triangles, squareDiamond, snowflake1, snowflake2, snowflake3);
-				generateSerpinsky(first, second, third, triangles, callbacks->getState().iterations);
-				serpinskyAllColored(triangles);
-				trianglesGPU.setVerts(triangles.verts);
-				trianglesGPU.setCols(triangles.cols);
+			if (arrived) {
+				const GeneratedScene& latest = worker.latest();
+				profiler.addCpuSample("generate", latest.ms);
+				ProfileScope scope(profiler, "upload");
+
+				ResidentScene& target = resident[latest.scene - 1];
+				bool colorsInShader = options.shaderColors && latest.scene == 1;
+				if (!target.batch) {
+					target.batch = std::make_unique<BatchedGeometry>(options.vertexFormat, options.bufferLayout, options.uploadMode);
+					target.batch->geometry().setShrinkPolicy(options.shrinkPolicy);
+					if (colorsInShader) target.batch->geometry().disableCols();
+				}
+
+				if (colormaps) {
+					// By which triangle, how deep, and how far around the snowflake
+					colormapValues.clear();
+					for (std::size_t i = 0; i < latest.parts.size(); i++) {
+						const CPU_Geometry& part = latest.parts[i];
+						if (latest.scene == 1) serpinskyBranchValues(part.verts.size(), partValues);
+						else if (latest.scene == 2) squareDiamondDepthValues(part.verts.size(), squareDiamondPoints.size(), partValues);
+						else arcLengthValues(part.verts, partValues, float(i) / float(latest.parts.size()), float(i + 1) / float(latest.parts.size()));
+						colormapValues.insert(colormapValues.end(), partValues.begin(), partValues.end());
+					}
+					target.batch->setPartVerts(latest.parts);
+					target.batch->geometry().setValues(colormapValues);
+				}
+				else if (colorsInShader) target.batch->setPartVerts(latest.parts);
+				else target.batch->setParts(latest.parts);
+				std::size_t vertices = target.batch->vertexCount();
+				target.level = latest.iterations;
+
+				if (colormaps) {
+					Log::info("COLORMAP scene {} level {}: {} bytes of values instead of {} bytes of colours",
+						latest.scene, latest.iterations, target.batch->geometry().valueBytes() * vertices,
+						(options.vertexFormat == VertexFormat::Compact ? sizeof(CompactColor) : sizeof(FloatColor)) * vertices);
+				}
+				else if (colorsInShader && options.bufferLayout == BufferLayout::Split) {
+					std::size_t colorBytes = (options.vertexFormat == VertexFormat::Compact) ? sizeof(CompactColor) : sizeof(FloatColor);
+					Log::info("SERPINSKY level {} with colours from the shader: {} bytes of colours not uploaded",
+						latest.iterations, colorBytes * vertices);
+				}
+
+				generated.scene = latest.scene;
+				generated.iterations = latest.iterations;
+				if (generated == state) shownScene = latest.scene;
+			}
+
+			// The camera applies to everything, however it was generated, except
+			// deep zooms, which come out with the camera already applied
+			const Camera2D& camera = callbacks->getCamera();
+			Camera2D view = options.deepZoom ? Camera2D() : camera;
+			instancedShader.use();
+			glUniform3f(instancedShader.uniformLocation("view"), float(view.center.x), float(view.center.y), float(view.zoom));
+			serpinskyShader.use();
+			glUniform3f(serpinskyShader.uniformLocation("view"), float(view.center.x), float(view.center.y), float(view.zoom));
+			colormapShader.use();
+			glUniform3f(colormapShader.uniformLocation("view"), float(view.center.x), float(view.center.y), float(view.zoom));
+			glUniform1f(colormapShader.uniformLocation("layer"), float(callbacks->getColormap()));
+			shader.use();
+			glUniform3f(shader.uniformLocation("view"), float(view.center.x), float(view.center.y), float(view.zoom));
+
+			if (options.lodPixels > 0.f) {
+				glm::ivec2 viewport = offscreen ? glm::ivec2(offscreen->getWidth(), offscreen->getHeight()) : window.getFramebufferSize();
+
+				if (!(lodState == state) || lodViewport != viewport || lodCamera != camera) {
+					ProfileScope scope(profiler, "generate");
+					AllocationScope allocations("generate lod");
+					ScreenSpace screen = ScreenSpace::forViewport(viewport, camera.center, camera.zoom);
+					LodOutput output = options.deepZoom ? LodOutput::CameraRelative : LodOutput::World;
+					if (state.scene == 1) generateSerpinskyLod(first, second, third, state.iterations, screen, options.lodPixels, output, lodGeometry, lodStats);
+					else if (state.scene == 2) generateSquareDiamondLod(squareDiamondPoints, state.iterations, screen, options.lodPixels, output, lodGeometry, lodStats);
+					else generateSnowflakeLod(first, second, third, state.iterations, screen, options.lodPixels, output, lodGeometry, lodStats);
+					lodGPU.setGeometry(lodGeometry);
+					lodState = state;
+					lodViewport = viewport;
+					lodCamera = camera;
+
+					Log::info("LOD scene {} level {} at {}x{}, zoom {:g}: {:g} primitives, {:g} pruned below {} pixels, {:g} culled off screen",
+						state.scene, state.iterations, viewport.x, viewport.y, camera.zoom,
+						lodStats.drawn, lodStats.pruned, options.lodPixels, lodStats.culled);
+				}
+
+				// Culled segments leave gaps in the snowflake, so it can't be drawn as one strip
+				GLenum modes[] = { GL_TRIANGLES, GL_LINE_STRIP, GL_LINES };
+				ProfileScope scope(profiler, "draw");
+				lodGPU.bind();
+				glDrawArrays(modes[state.scene - 1], 0, GLsizei(lodGeometry.verts.size()));
+			}
+			else if (options.chunked) {
+				ProfileScope scope(profiler, "chunks");
+				AllocationScope allocations("chunks");
+				ChunkedFractal& fractal = *chunkedScenes[state.scene - 1];
+				if (!(chunkedState == state)) fractal.setLevel(state.iterations, chunkStream->chunkVertices());
+
+				GLenum mode = (state.scene == 1) ? GL_TRIANGLES : GL_LINE_STRIP;
+				chunkStream->draw(fractal, mode);
+
+				if (!(chunkedState == state)) {
+					Log::info("CHUNKED scene {} level {}: {} vertices in {} chunks of up to {}",
+						state.scene, state.iterations, chunkStream->stats().vertices, chunkStream->stats().chunks,
+						fractal.chunkVertices());
+					chunkedState = state;
+				}
+			}
+			else if (gpuGenerator && (state.scene == 1 || state.scene == 3)) {
+				int scene = state.scene;
+				int iterations = state.iterations;
+
+				if (gpuScene != scene || gpuLevel != iterations) {
+					ProfileScope scope(profiler, "generate");
+					AllocationScope allocations("generate gpu");
+					if (scene == 1) gpuGenerator->generateSerpinsky(first, second, third, iterations);
+					else gpuGenerator->generateSnowflake(first, second, third, iterations);
+					if (scene == 1 && options.compareGenerators) compareSerpinsky(*gpuGenerator, first, second, third, iterations);
+					gpuScene = scene;
+					gpuLevel = iterations;
+				}
+
+				// Generating switches to the feedback programs
+				shader.use();
+				gpuGenerator->draw();
+			}
+			else if (state.scene == 1 && options.instanced) {
+				int iterations = state.iterations;
+				int base = std::min(iterations, options.instanceBase);
+
+				if (instancedLevel != iterations) {
+					ProfileScope scope(profiler, "generate");
+					AllocationScope allocations("generate serpinsky instanced");
+					if (uploadedBase != base) {
+						triangles.setLevel(base);
+						trianglesGPU.setGeometry(triangles.geometry());
+						uploadedBase = base;
+					}
+					generateSerpinskyInstances(first, second, third, iterations - base, instances);
+					trianglesGPU.setInstances(instances);
+					instancedLevel = iterations;
+
+					Log::info("SERPINSKY level {} as {} instances of level {}: {} bytes of vertices and instances instead of {}",
+						iterations, instances.size(), base,
+						trianglesGPU.vertexBytes() * triangles.geometry().verts.size() + sizeof(glm::vec3) * instances.size(),
+						trianglesGPU.vertexBytes() * 3 * serpinskyTriangleCount(iterations));
+				}
+
+				instancedShader.use();
 				trianglesGPU.bind();
-				glDrawArrays(GL_TRIANGLES, 0, GLsizei(triangles.verts.size()));
+				glDrawArraysInstanced(GL_TRIANGLES, 0, GLsizei(triangles.geometry().verts.size()), GLsizei(instances.size()));
 			}
-			else if (callbacks->getState().scene == 2) {
-				clearScene(triangles, squareDiamond, snowflake1, snowflake2, snowflake3);
-				generateSquareDiamond(squareDiamond, callbacks->getState().iterations, squareDiamondPoints);
-				squareDiamondGPU.setVerts(squareDiamond.verts);
-				squareDiamondGPU.setCols(squareDiamond.cols);
-				squareDiamondGPU.bind();
-				glDrawArrays(GL_LINE_STRIP, 0, GLsizei(squareDiamond.verts.size()));
+			else if (state.scene == 1 && options.indexed) {
+				int iterations = state.iterations;
+
+				if (indexedLevel != iterations) {
+					ProfileScope scope(profiler, "generate");
+					AllocationScope allocations("generate serpinsky indexed");
+					generateSerpinskyIndexed(first, second, third, indexedTriangles, triangleIndices, iterations);
+					colorSerpinsky(indexedTriangles, iterations);
+					trianglesGPU.setGeometry(indexedTriangles);
+					trianglesGPU.setIndices(triangleIndices, indexedTriangles.verts.size());
+					indexedLevel = iterations;
+
+					std::size_t flatBytes = trianglesGPU.vertexBytes() * triangleIndices.size();
+					std::size_t indexedBytes = trianglesGPU.vertexBytes() * indexedTriangles.verts.size() + trianglesGPU.indexBytes();
+					Log::info("SERPINSKY level {} indexed: {} vertices and {} {} bit indices, {} bytes instead of {} ({} saved)",
+						iterations, indexedTriangles.verts.size(), triangleIndices.size(),
+						trianglesGPU.indexType() == GL_UNSIGNED_SHORT ? 16 : 32,
+						indexedBytes, flatBytes, std::ptrdiff_t(flatBytes) - std::ptrdiff_t(indexedBytes));
+				}
+
+				trianglesGPU.bind();
+				glDrawElements(GL_TRIANGLES, trianglesGPU.indexCount(), trianglesGPU.indexType(), (void*)0);
 			}
-			else if (callbacks->getState().scene == 3) {
-				clearScene(triangles, squareDiamond, snowflake1, snowflake2, snowflake3);
-				generateSnowflake(snowflake1, first, second, BLUE, callbacks->getState().iterations);
-				generateSnowflake(snowflake2, second, third, BLUE, callbacks->getState().iterations);
-				generateSnowflake(snowflake3, third, first, BLUE, callbacks->getState().iterations);
-
-				snowflake1GPU.setVerts(snowflake1.verts);
-				snowflake1GPU.setCols(snowflake1.cols);
-				snowflake1GPU.bind();
-				glDrawArrays(GL_LINE_STRIP, 0, GLsizei(snowflake1.verts.size()));
-
-				snowflake2GPU.setVerts(snowflake2.verts);
-				snowflake2GPU.setCols(snowflake2.cols);
-				snowflake2GPU.bind();
-				glDrawArrays(GL_LINE_STRIP, 0, GLsizei(snowflake2.verts.size()));
-
-				snowflake3GPU.setVerts(snowflake3.verts);
-				snowflake3GPU.setCols(snowflake3.cols);
-				snowflake3GPU.bind();
-				glDrawArrays(GL_LINE_STRIP, 0, GLsizei(snowflake3.verts.size()));
-				
+			else if (shownScene != 0) {
+				ProfileScope scope(profiler, "draw");
+				// Everything it draws is already on the GPU. Declared after the profiler
+				// scope, so the sample that one records is left out.
+				AllocationScope allocations("draw resident", AllocationScope::Expect::None);
+				ResidentScene& shown = resident[shownScene - 1];
+				bool colorsInShader = options.shaderColors && shownScene == 1;
+				if (colormaps) colormapShader.use();
+				if (colorsInShader) {
+					serpinskyShader.use();
+					glUniform1ui(serpinskyShader.uniformLocation("level"), GLuint(shown.level));
+					// gl_VertexID already counts from the start of the batch, not of each part
+					glUniform1ui(serpinskyShader.uniformLocation("firstVertex"), 0);
+				}
+
+				shown.batch->draw(shown.mode);
+
+				if (colorsInShader || colormaps) shader.use();
 			}
+
+			glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
 		}
 
-		
-		
+		{
+			ProfileScope scope(profiler, "swap");
+			// Nothing to present offscreen, but the frame should still include the GPU's share
+			if (offscreen) glFinish();
+			else window.swapBuffers();
+		}
+		profiler.endFrame();
+	}
+
+	double loopMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loopStart).count();
+	if (options.frames > 0) {
+		Log::info("Rendered {} frames in {:.1f} ms, {:.3f} ms per frame", frame, loopMs, loopMs / std::max(frame, 1));
+	}
+	if (offscreen && !options.screenshot.empty() && offscreen->save(options.screenshot)) {
+		Log::info("Saved the last frame to {}", options.screenshot);
+	}
 
-		glDisable(GL_FRAMEBUFFER_SRGB); // disable sRGB for things like imgui
+	const VertexBuffer::Stats& buffers = VertexBuffer::totals();
+	Log::info("VertexBuffer: {} uploads ({} bytes), {} allocations ({} bytes)",
+		buffers.uploads, buffers.uploadedBytes, buffers.allocations, buffers.allocatedBytes);
+	const StreamBuffer::Stats& streams = StreamBuffer::totals();
+	if (streams.uploads > 0) {
+		Log::info("StreamBuffer: {} uploads ({} bytes), {} wraps, {} grows, {} stalls ({})",
+			streams.uploads, streams.bytes, streams.wraps, streams.grows, streams.stalls,
+			StreamBuffer::persistentSupported() ? "persistent" : "unsynchronized maps");
+	}
+	reportAllocations();
+	if (allocationViolations() > 0) {
+		Log::error("ALLOCATIONS {} scopes that should not allocate did", allocationViolations());
+	}
 
-		window.swapBuffers();
+	if (options.prefetchBudget > 0 && !options.syncGeneration && !options.chunked && options.lodPixels == 0.f) {
+		GenerationWorker::PrefetchStats prefetch = worker.prefetchStats();
+		Log::info("PREFETCH {} of {} requests were ready, {} levels prefetched, {} evicted, {} skipped, {} cancelled, {} bytes held",
+			prefetch.hits, prefetch.hits + prefetch.misses, prefetch.prefetched, prefetch.evicted, prefetch.skipped, prefetch.cancelled,
+			prefetch.bytes);
 	}
 
+	return allocationViolations();
+}
+
+
+int main(int argc, char** argv) {
+	Log::debug("Starting main");
+
+	Options options = parseOptions(argc, argv);
+
+	glfwInit();
+	std::uint64_t violations = run(options);
 	glfwTerminate();
-	return 0;
+
+	// So a CI run of --headless --frames=<n> fails when a frame allocates that must not
+	return (violations > 0) ? 1 : 0;
 }
@@ -0,0 +1,14 @@
+#version 330 core
+out vec4 color;
+
+in float T;
+
+uniform sampler1DArray colormap;
+uniform float layer; // which map, see ColorMapTexture
+
+void main() {
+	// 0 and 1 land on the middle of the first and last texel, which hold the ends of the map
+	float width = float(textureSize(colormap, 0).x);
+	float u = (0.5 + T * (width - 1.0)) / width;
+	color = vec4(texture(colormap, vec2(u, layer)).rgb, 1.0f);
+}
@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in float value; // in [0, 1], where in the colour map
+
+uniform vec3 view; // xy is the point in the middle of the window, z the zoom
+
+out float T;
+
+void main() {
+	T = value;
+	gl_Position = vec4((pos.xy - view.xy) * view.z, pos.z, 1.0);
+}
@@ -0,0 +1,11 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 col;
+
+out vec3 vPos;
+out vec3 vCol;
+
+void main() {
+	vPos = pos;
+	vCol = col;
+}
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+layout (location = 1) in vec3 col;
+layout (location = 2) in vec3 instance; // xy is the offset, z the scale
+
+uniform vec3 view; // xy is the point in the middle of the window, z the zoom
+
+out vec3 C;
+
+void main() {
+	C = col;
+	gl_Position = vec4((instance.xy + instance.z * pos.xy - view.xy) * view.z, 0.0, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 pos;
+
+uniform vec3 view; // xy is the point in the middle of the window, z the zoom
+uniform uint level;
+uniform uint firstVertex; // of the level, for draws that start partway through it
+
+out vec3 C;
+
+#include "serpinsky_color.glsl"
+
+// Same as colorSerpinsky, without a colour buffer to read it from
+void main() {
+	C = serpinskyColor(level, uint(gl_VertexID) + firstVertex);
+	gl_Position = vec4((pos.xy - view.xy) * view.z, pos.z, 1.0);
+}
@@ -0,0 +1,18 @@
+// Shared by the shaders that colour the Serpinsky triangle, which #include it
+// (see Shader.cpp). Same as serpinskyHash and serpinskyColor in Fractals.cpp,
+// so the CPU and GPU give every vertex the same colour.
+
+// lowbias32 by Chris Wellons, https://nullprogram.com/blog/2018/07/31/
+uint hash(uint x) {
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+vec3 serpinskyColor(uint level, uint vertex) {
+	uint h = hash(vertex + hash(level));
+	return vec3(float(h & 0x7ffu) / 2047.0, float((h >> 11) & 0x7ffu) / 2047.0, float(h >> 22) / 1023.0);
+}
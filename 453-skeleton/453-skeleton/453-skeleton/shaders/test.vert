@@ -2,9 +2,11 @@
 layout (location = 0) in vec3 pos;
 layout (location = 1) in vec3 col;
 
+uniform vec3 view; // xy is the point in the middle of the window, z the zoom
+
 out vec3 C;
 
 void main() {
 	C = col;
-	gl_Position = vec4(pos, 1.0);
+	gl_Position = vec4((pos.xy - view.xy) * view.z, pos.z, 1.0);
 }
@@ -0,0 +1,523 @@
+//------------------------------------------------------------------------------
+// Benchmarks for the fractal generators.
+//
+// By default every generator ("engine") of the selected scenes is timed over
+// a range of iterations and the results are written as JSON, see README.txt
+// for the options. --compare prints the older before/after tables instead.
+//
+// Runs without a window or OpenGL context. Build with optimizations on
+// (-DCMAKE_BUILD_TYPE=Release), the numbers from a debug build mean nothing.
+//------------------------------------------------------------------------------
+
+#include "AllocationCounter.h"
+#include "Fractals.h"
+#include "IncrementalFractals.h"
+#include "Koch.h"
+#include "Log.h"
+#include "ThreadPool.h"
+
+#include <argh.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	// Best wall time of reps calls of f, in milliseconds
+	template <typename F>
+	double bestOf(int reps, F&& f) {
+		double best = 0.0;
+		for (int i = 0; i < reps; i++) {
+			auto start = Clock::now();
+			f();
+			double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			best = (i == 0) ? ms : std::min(best, ms);
+		}
+		return best;
+	}
+
+	bool sameVerts(const CPU_Geometry& x, const CPU_Geometry& y) {
+		return x.verts.size() == y.verts.size()
+			&& std::memcmp(x.verts.data(), y.verts.data(), sizeof(glm::vec3) * x.verts.size()) == 0;
+	}
+
+	// Corners of the Serpinsky triangle, same as the scene in main.cpp
+	glm::vec2 const A(0.f, 0.5f);
+	glm::vec2 const B(-0.5f, -0.5f);
+	glm::vec2 const C(0.5f, -0.5f);
+
+
+	void benchSerpinskyIterative() {
+		std::vector<float> first{ 0.0, 0.5 };
+		std::vector<float> second{ -0.5, -0.5 };
+		std::vector<float> third{ 0.5, -0.5 };
+
+		Log::info("BENCH Serpinsky triangle, recursive generateSerpinsky vs generateSerpinskyIterative");
+		fmt::print("{:>5} {:>12} {:>14} {:>14} {:>9} {:>10}\n", "iter", "triangles", "recursive ms", "iterative ms", "speedup", "identical");
+
+		for (int iterations = 8; iterations <= 15; iterations++) {
+			int reps = iterations <= 12 ? 5 : 1;
+
+			CPU_Geometry reference;
+			double recursiveMs = bestOf(reps, [&]() {
+				reference.verts.clear();
+				generateSerpinsky(first, second, third, reference, iterations);
+			});
+
+			// Warm the buffer once, every timed call after that reuses its capacity
+			CPU_Geometry triangles;
+			generateSerpinskyIterative(A, B, C, triangles, iterations);
+			const glm::vec3* storage = triangles.verts.data();
+
+			double iterativeMs = bestOf(reps, [&]() {
+				generateSerpinskyIterative(A, B, C, triangles, iterations);
+			});
+
+			if (triangles.verts.data() != storage) {
+				Log::error("BENCH generateSerpinskyIterative reallocated at iteration {}", iterations);
+			}
+
+			fmt::print("{:>5} {:>12} {:>14.2f} {:>14.2f} {:>8.1f}x {:>10}\n",
+				iterations, serpinskyTriangleCount(iterations), recursiveMs, iterativeMs,
+				recursiveMs / iterativeMs, sameVerts(reference, triangles) ? "yes" : "NO");
+		}
+	}
+
+	void benchSerpinskyParallel() {
+		unsigned maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+		Log::info("BENCH Serpinsky triangle, generateSerpinskyParallel scaling over 1..{} threads", maxThreads);
+		fmt::print("{:>5} {:>8} {:>12} {:>9} {:>11} {:>10}\n", "iter", "threads", "ms", "speedup", "efficiency", "identical");
+
+		for (int iterations = 10; iterations <= 15; iterations++) {
+			int reps = iterations <= 12 ? 5 : 2;
+
+			CPU_Geometry serial;
+			generateSerpinskyIterative(A, B, C, serial, iterations);
+
+			CPU_Geometry triangles;
+			double singleMs = 0.0;
+			for (unsigned threads = 1; threads <= maxThreads; threads++) {
+				ThreadPool pool(threads);
+				generateSerpinskyParallel(A, B, C, triangles, iterations, pool);
+
+				double ms = bestOf(reps, [&]() {
+					generateSerpinskyParallel(A, B, C, triangles, iterations, pool);
+				});
+				if (threads == 1) singleMs = ms;
+
+				fmt::print("{:>5} {:>8} {:>12.2f} {:>8.2f}x {:>10.0f}% {:>10}\n",
+					iterations, threads, ms, singleMs / ms, 100.0 * singleMs / (ms * threads),
+					sameVerts(serial, triangles) ? "yes" : "NO");
+			}
+		}
+	}
+
+	// Bytes of positions and colours per level, one vertex per triangle corner
+	// against shared corners plus indices, 16 bit when they can address every vertex
+	void benchSerpinskyIndexed() {
+		Log::info("BENCH Serpinsky triangle, generateSerpinskyIterative vs generateSerpinskyIndexed");
+		fmt::print("{:>5} {:>10} {:>10} {:>6} {:>12} {:>12} {:>8} {:>12} {:>12} {:>10}\n",
+			"iter", "vertices", "unique", "index", "flat bytes", "indexed", "saved", "flat ms", "indexed ms", "identical");
+
+		for (int iterations = 0; iterations <= 13; iterations++) {
+			int reps = iterations <= 11 ? 5 : 2;
+
+			CPU_Geometry flat;
+			generateSerpinskyIterative(A, B, C, flat, iterations);
+			double flatMs = bestOf(reps, [&]() { generateSerpinskyIterative(A, B, C, flat, iterations); });
+
+			CPU_Geometry shared;
+			std::vector<std::uint32_t> indices;
+			generateSerpinskyIndexed(A, B, C, shared, indices, iterations);
+			double indexedMs = bestOf(reps, [&]() { generateSerpinskyIndexed(A, B, C, shared, indices, iterations); });
+
+			bool identical = indices.size() == flat.verts.size();
+			for (std::size_t i = 0; identical && i < indices.size(); i++) {
+				identical = std::memcmp(&shared.verts[indices[i]], &flat.verts[i], sizeof(glm::vec3)) == 0;
+			}
+
+			// Same rule as GPU_Geometry::setIndices
+			std::size_t indexSize = shared.verts.size() <= 0x10000 ? 2 : 4;
+			std::size_t flatBytes = 2 * sizeof(glm::vec3) * flat.verts.size();
+			std::size_t indexedBytes = 2 * sizeof(glm::vec3) * shared.verts.size() + indexSize * indices.size();
+
+			fmt::print("{:>5} {:>10} {:>10} {:>5}b {:>12} {:>12} {:>7.1f}% {:>12.2f} {:>12.2f} {:>10}\n",
+				iterations, flat.verts.size(), shared.verts.size(), 8 * indexSize, flatBytes, indexedBytes,
+				100.0 * (1.0 - double(indexedBytes) / double(flatBytes)), flatMs, indexedMs, identical ? "yes" : "NO");
+		}
+	}
+
+	// Largest coordinate difference between two snowflake sides, or infinity if
+	// they don't even have the same vertices and colours
+	float maxDifference(const CPU_Geometry& x, const CPU_Geometry& y) {
+		if (x.verts.size() != y.verts.size() || x.cols != y.cols) return INFINITY;
+
+		float difference = 0.f;
+		for (std::size_t i = 0; i < x.verts.size(); i++) {
+			glm::vec3 d = glm::abs(x.verts[i] - y.verts[i]);
+			difference = std::max(difference, std::max(d.x, d.y));
+		}
+		return difference;
+	}
+
+	void benchSnowflakeBreadthFirst() {
+		std::vector<float> first{ 0.0, 0.5 };
+		std::vector<float> second{ -0.5, -0.5 };
+
+		std::vector<KochPath> paths{ KochPath::Scalar };
+		if (supportedKochPath(KochPath::SSE2) == KochPath::SSE2) paths.push_back(KochPath::SSE2);
+		if (supportedKochPath(KochPath::AVX2) == KochPath::AVX2) paths.push_back(KochPath::AVX2);
+
+		Log::info("BENCH Koch snowflake side, recursive generateSnowflake vs generateSnowflakeBreadthFirst");
+		fmt::print("{:>5} {:>10} {:>8} {:>14} {:>12} {:>9} {:>12}\n", "iter", "segments", "path", "recursive ms", "kernel ms", "speedup", "max diff");
+
+		for (int iterations = 6; iterations <= 11; iterations++) {
+			int reps = iterations <= 9 ? 5 : 2;
+
+			CPU_Geometry reference;
+			double recursiveMs = bestOf(reps, [&]() {
+				reference.verts.clear();
+				reference.cols.clear();
+				generateSnowflake(reference, first, second, BLUE, iterations);
+			});
+
+			for (KochPath path : paths) {
+				CPU_Geometry side;
+				KochBuffers buffers;
+				buffers.path = path;
+
+				double kernelMs = bestOf(reps, [&]() {
+					generateSnowflakeBreadthFirst(side, A, B, iterations, buffers);
+				});
+
+				fmt::print("{:>5} {:>10} {:>8} {:>14.2f} {:>12.2f} {:>8.1f}x {:>12.3g}\n",
+					iterations, side.verts.size() / 2, kochPathName(path), recursiveMs, kernelMs,
+					recursiveMs / kernelMs, maxDifference(reference, side));
+			}
+		}
+	}
+
+	// Stepping a retained level up and down by one, against building the target level from scratch
+	void benchLevelStepping() {
+		Log::info("BENCH level stepping, derived from the previous level vs generated from scratch");
+		fmt::print("{:>10} {:>5} {:>12} {:>12} {:>12} {:>10}\n", "scene", "step", "scratch ms", "up ms", "down ms", "identical");
+
+		for (int iterations = 8; iterations <= 13; iterations++) {
+			CPU_Geometry triangles;
+			double scratchMs = bestOf(1, [&]() {
+				generateSerpinskyIterative(A, B, C, triangles, iterations);
+				colorSerpinsky(triangles, iterations);
+			});
+
+			SerpinskyLevels levels(A, B, C);
+			levels.setLevel(iterations - 1);
+			double upMs = bestOf(1, [&]() { levels.setLevel(iterations); });
+			bool identical = sameVerts(levels.geometry(), triangles);
+
+			levels.setLevel(iterations + 1);
+			double downMs = bestOf(1, [&]() { levels.setLevel(iterations); });
+			identical = identical && sameVerts(levels.geometry(), triangles);
+
+			fmt::print("{:>10} {:>2}->{:<2} {:>12.2f} {:>12.2f} {:>12.2f} {:>10}\n",
+				"serpinsky", iterations - 1, iterations, scratchMs, upMs, downMs, identical ? "yes" : "NO");
+		}
+
+		for (int iterations = 6; iterations <= 11; iterations++) {
+			CPU_Geometry side;
+			KochBuffers buffers;
+			double scratchMs = bestOf(1, [&]() { generateSnowflakeBreadthFirst(side, A, B, iterations, buffers); });
+
+			SnowflakeLevels levels(A, B);
+			levels.setLevel(iterations - 1);
+			double upMs = bestOf(1, [&]() { levels.setLevel(iterations); });
+			bool identical = sameVerts(levels.geometry(), side) && levels.geometry().cols == side.cols;
+
+			levels.setLevel(iterations + 1);
+			double downMs = bestOf(1, [&]() { levels.setLevel(iterations); });
+			identical = identical && sameVerts(levels.geometry(), side) && levels.geometry().cols == side.cols;
+
+			fmt::print("{:>10} {:>2}->{:<2} {:>12.2f} {:>12.2f} {:>12.2f} {:>10}\n",
+				"koch", iterations - 1, iterations, scratchMs, upMs, downMs, identical ? "yes" : "NO");
+		}
+	}
+}
+
+
+//------------------------------------------------------------------------------
+// Microbenchmarks with JSON output
+
+
+namespace {
+
+	// Peak resident set size of the whole process so far, in KiB. It never goes
+	// down, so a run only shows up here if it needed more than everything before it.
+	long peakRssKiB() {
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+		return long(counters.PeakWorkingSetSize / 1024);
+#else
+		rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#if defined(__APPLE__)
+		return long(usage.ru_maxrss / 1024); // bytes there
+#else
+		return long(usage.ru_maxrss);
+#endif
+#endif
+	}
+
+	// One generator of one scene. run builds the given level and returns how many
+	// vertices it produced. Each engine keeps its buffers between calls, like the
+	// app does, so only the first repetition of a level pays for allocation.
+	// Engines that never allocate once warm are held to it: with COUNT_ALLOCATIONS,
+	// an allocation on their thread after the first repetition is a violation.
+	struct Engine {
+		const char* scene;
+		const char* name;
+		std::function<std::size_t(int)> run;
+		bool allocationFree = false;
+	};
+
+	std::vector<std::vector<float>> const SQUARE_DIAMOND_POINTS{
+		{ 0.5f, 0.5f }, { -0.5f, 0.5f }, { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f },
+		{ 0.f, 0.5f }, { -0.5f, 0.f }, { 0.f, -0.5f }, { 0.5f, 0.f }, { 0.f, 0.5f }
+	};
+
+	// Every engine there is. New generators only need an entry here.
+	std::vector<Engine> makeEngines(ThreadPool& pool) {
+		auto serpinsky = std::make_shared<CPU_Geometry>();
+		auto indices = std::make_shared<std::vector<std::uint32_t>>();
+		auto squareDiamond = std::make_shared<CPU_Geometry>();
+		auto sides = std::make_shared<std::vector<CPU_Geometry>>(3);
+		auto buffers = std::make_shared<KochBuffers>();
+		glm::vec2 const corners[] = { A, B, C };
+		std::vector<float> const points[] = { { A.x, A.y }, { B.x, B.y }, { C.x, C.y } };
+
+		return {
+			{ "serpinsky", "recursive", [=](int iterations) {
+				serpinsky->verts.clear();
+				generateSerpinsky(points[0], points[1], points[2], *serpinsky, iterations);
+				return serpinsky->verts.size();
+			} },
+			{ "serpinsky", "iterative", [=](int iterations) {
+				generateSerpinskyIterative(A, B, C, *serpinsky, iterations);
+				return serpinsky->verts.size();
+			}, true },
+			// Pool tasks are std::functions in deques, submitting them allocates
+			{ "serpinsky", "parallel", [=, &pool](int iterations) {
+				generateSerpinskyParallel(A, B, C, *serpinsky, iterations, pool);
+				return serpinsky->verts.size();
+			} },
+			{ "serpinsky", "indexed", [=](int iterations) {
+				generateSerpinskyIndexed(A, B, C, *serpinsky, *indices, iterations);
+				return serpinsky->verts.size();
+			}, true },
+			// Geometry and colours together, rand() as it was against the counter-based colours
+			{ "serpinsky", "randcolors", [=](int iterations) {
+				generateSerpinskyIterative(A, B, C, *serpinsky, iterations);
+				serpinsky->cols.clear();
+				serpinskyAllColored(*serpinsky);
+				return serpinsky->verts.size();
+			}, true },
+			{ "serpinsky", "hashcolors", [=](int iterations) {
+				generateSerpinskyIterative(A, B, C, *serpinsky, iterations);
+				colorSerpinsky(*serpinsky, iterations);
+				return serpinsky->verts.size();
+			}, true },
+			{ "serpinsky", "parallelcolors", [=, &pool](int iterations) {
+				generateSerpinskyParallel(A, B, C, *serpinsky, iterations, pool);
+				colorSerpinsky(*serpinsky, iterations, 0, &pool);
+				return serpinsky->verts.size();
+			} },
+			// Every run starts from new levels, so these allocate on purpose
+			{ "serpinsky", "levels", [=, &pool](int iterations) {
+				// Stepped up from level 0, the way the app gets there with the arrow keys
+				SerpinskyLevels levels(A, B, C, &pool);
+				levels.setLevel(iterations);
+				return levels.geometry().verts.size();
+			} },
+			{ "squarediamond", "recursive", [=](int iterations) {
+				squareDiamond->verts.clear();
+				squareDiamond->cols.clear();
+				generateSquareDiamond(*squareDiamond, iterations, SQUARE_DIAMOND_POINTS);
+				return squareDiamond->verts.size();
+			} },
+			{ "squarediamond", "levels", [=](int iterations) {
+				SquareDiamondLevels levels(SQUARE_DIAMOND_POINTS);
+				levels.setLevel(iterations);
+				return levels.geometry().verts.size();
+			} },
+			{ "snowflake", "recursive", [=](int iterations) {
+				std::size_t vertices = 0;
+				for (int side = 0; side < 3; side++) {
+					CPU_Geometry& geom = (*sides)[side];
+					geom.verts.clear();
+					geom.cols.clear();
+					generateSnowflake(geom, points[side], points[(side + 1) % 3], BLUE, iterations);
+					vertices += geom.verts.size();
+				}
+				return vertices;
+			} },
+			{ "snowflake", "breadthfirst", [=](int iterations) {
+				std::size_t vertices = 0;
+				for (int side = 0; side < 3; side++) {
+					generateSnowflakeBreadthFirst((*sides)[side], corners[side], corners[(side + 1) % 3], iterations, *buffers);
+					vertices += (*sides)[side].verts.size();
+				}
+				return vertices;
+			}, true },
+			{ "snowflake", "levels", [=](int iterations) {
+				std::size_t vertices = 0;
+				for (int side = 0; side < 3; side++) {
+					SnowflakeLevels levels(corners[side], corners[(side + 1) % 3]);
+					levels.setLevel(iterations);
+					vertices += levels.geometry().verts.size();
+				}
+				return vertices;
+			} },
+		};
+	}
+
+	struct MicroOptions {
+		std::string scene = "all";
+		std::string engine = "all";
+		int minIterations = 0;
+		int maxIterations = -1; // per scene default
+		int reps = 10;
+		unsigned threads = 0;   // hardware concurrency
+		std::string json;       // stdout when empty
+	};
+
+	// Deepest level benchmarked when --max-iterations isn't given, around a second per repetition
+	int defaultMaxIterations(const std::string& scene) {
+		if (scene == "serpinsky") return 12;
+		if (scene == "snowflake") return 9;
+		return 16;
+	}
+
+	double percentile(std::vector<double> sorted, double p) {
+		std::size_t index = std::size_t(p * double(sorted.size() - 1) + 0.5);
+		return sorted[std::min(index, sorted.size() - 1)];
+	}
+
+	int runMicrobenchmarks(const MicroOptions& options) {
+		ThreadPool pool(options.threads == 0 ? std::max(std::thread::hardware_concurrency(), 1u) : options.threads);
+		std::vector<Engine> engines = makeEngines(pool);
+
+		std::FILE* out = stdout;
+		if (!options.json.empty()) {
+			out = std::fopen(options.json.c_str(), "w");
+			if (out == nullptr) {
+				fmt::print(stderr, "Could not open {} for writing\n", options.json);
+				return 1;
+			}
+		}
+
+		fmt::print(out, "{{\n  \"threads\": {},\n  \"reps\": {},\n  \"results\": [", pool.size(), options.reps);
+
+		bool first = true;
+		for (const Engine& engine : engines) {
+			if (options.scene != "all" && options.scene != engine.scene) continue;
+			if (options.engine != "all" && options.engine != engine.name) continue;
+
+			int maxIterations = options.maxIterations >= 0 ? options.maxIterations : defaultMaxIterations(engine.scene);
+			for (int iterations = options.minIterations; iterations <= maxIterations; iterations++) {
+				fmt::print(stderr, "{} {} {}\n", engine.scene, engine.name, iterations);
+
+				std::vector<double> ms(std::size_t(std::max(options.reps, 1)));
+				std::size_t vertices = 0;
+				AllocationCounts allocations;
+				for (std::size_t rep = 0; rep < ms.size(); rep++) {
+					// The first repetition warms the buffers up
+					bool warm = (rep > 0 && engine.allocationFree);
+					AllocationScope scope(engine.name, warm ? AllocationScope::Expect::None : AllocationScope::Expect::Any);
+
+					// Every thread, the parallel engines allocate on the pool too
+					AllocationCounts before = processAllocations();
+					auto start = Clock::now();
+					vertices = engine.run(iterations);
+					ms[rep] = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+					AllocationCounts after = processAllocations();
+					allocations.allocations = after.allocations - before.allocations;
+					allocations.bytes = after.bytes - before.bytes;
+				}
+				std::sort(ms.begin(), ms.end());
+
+				// Only the last repetition, the others may have warmed up the buffers
+				std::string allocated;
+				if (allocationCountingEnabled()) {
+					allocated = fmt::format(", \"allocations\": {}, \"allocated_bytes\": {}", allocations.allocations, allocations.bytes);
+				}
+
+				double p50 = percentile(ms, 0.50);
+				double seconds = p50 / 1e3;
+				fmt::print(out,
+					"{}\n    {{ \"scene\": \"{}\", \"engine\": \"{}\", \"iterations\": {}, \"vertices\": {}, "
+					"\"min_ms\": {:.6f}, \"p50_ms\": {:.6f}, \"p99_ms\": {:.6f}, "
+					"\"vertices_per_sec\": {:.1f}, \"ns_per_vertex\": {:.3f}, \"peak_rss_kib\": {}{} }}",
+					first ? "" : ",", engine.scene, engine.name, iterations, vertices,
+					ms.front(), p50, percentile(ms, 0.99),
+					seconds > 0.0 ? double(vertices) / seconds : 0.0,
+					vertices > 0 ? p50 * 1e6 / double(vertices) : 0.0, peakRssKiB(), allocated);
+				first = false;
+			}
+		}
+
+		fmt::print(out, "\n  ]\n}}\n");
+		if (out != stdout) std::fclose(out);
+
+		if (allocationViolations() > 0) {
+			fmt::print(stderr, "BENCH {} repetitions of allocation free engines allocated\n", allocationViolations());
+			return 1;
+		}
+		return 0;
+	}
+}
+
+
+int main(int argc, char** argv) {
+	argh::parser cmdl(argc, argv);
+
+#ifndef NDEBUG
+	fmt::print(stderr, "BENCH built without optimizations, timings are not representative\n");
+#endif
+
+	if (cmdl["--compare"]) {
+		benchSerpinskyIterative();
+		benchSerpinskyParallel();
+		benchSerpinskyIndexed();
+		benchSnowflakeBreadthFirst();
+		benchLevelStepping();
+		return 0;
+	}
+
+	MicroOptions options;
+	cmdl("--scene", options.scene) >> options.scene;
+	cmdl("--engine", options.engine) >> options.engine;
+	cmdl("--min-iterations", options.minIterations) >> options.minIterations;
+	cmdl("--max-iterations", options.maxIterations) >> options.maxIterations;
+	cmdl("--reps", options.reps) >> options.reps;
+	cmdl("--threads", options.threads) >> options.threads;
+	cmdl("--json") >> options.json;
+
+	return runMicrobenchmarks(options);
+}